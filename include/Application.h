@@ -1,11 +1,16 @@
 #ifndef APPLICATION_H
 #define APPLICATION_H
 
+// Std include
+#include <vector>
+
 // Sfml include
 // - Graphics
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Sprite.hpp>
 #include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/RectangleShape.hpp>
 
 // - Window
 #include <SFML/Window/Event.hpp>
@@ -20,9 +25,31 @@
 
 // Personal include
 #include "Render.h"
+#include "JobManifest.h"
+#include "ScreenshotQueue.h"
+#include "ResolutionController.h"
 
 class Application
 {
+    // Milliseconds between two reads of the inputs during a rendering
+    static constexpr int inputLatency = 30;
+
+    // Milliseconds of a frame of lower resolution while the navigation keys are held, by default
+    static constexpr int previewFrameTime = 16;
+
+    // Zoom of the Z / S keys
+    static constexpr double zoomFactor = 1.3;
+
+    // Budget of the views computed ahead : threads, and memory of the cache of frames
+    static constexpr unsigned prefetchThreadCount = 2;
+    static constexpr std::size_t prefetchCacheMegabytes = 128;
+
+    // Detail level below which a minibrot reached by N doesn't show, for each iteration of its period
+    static constexpr unsigned minibrotDetailPerPeriod = 32;
+
+    // Sides of the screenshots of Shift + E in window sizes, computed again in the background
+    static constexpr unsigned screenshotScale = 2;
+
     enum class Direction{
         Up,
         Down,
@@ -38,27 +65,62 @@ class Application
         void update();
 
         void draw();
+        // False while the window shows the current state
+        bool needRedraw() const noexcept;
+
+        // Open a snapshot of a view, saved with its screen
+        bool loadSnapshot(const std::string &fileName);
+
+        // Continue the video of a job manifest left by a stopped one, closes the window
+        bool resumeVideo(const std::string &manifestName);
+
+        // Handle an input which didn't come from the window, as a replayed one
+        void simulateEvent(sf::Event event);
+        // Hold or release a key which didn't come from the keyboard, its presses are sent with simulateEvent
+        void simulateKey(sf::Keyboard::Key key, bool held);
+        // True when the window shows the finished rendering of the current view and no input waits
+        bool isIdle() const;
+        // True once a frame of the current view is shown, the preview or the finished rendering
+        bool isViewShown() const noexcept;
+
+        // Time of a frame while the view is moved, its resolution is lowered to fit in it
+        void setPreviewFrameTime(sf::Time frameTime) noexcept;
 
     private:
 
+        void handleOneEvent(sf::Event event);
         void handleMouseEvent(sf::Event event);
         void handleKeyPressedEvent(sf::Event event);
+        void showPreview();
 
         void drawInfo() noexcept;
+        void updateInfo() noexcept;
         std::string getZoomText(double zoom) const noexcept;
 
         // Key event
         void move(Direction dir);
+        sf::Vector2<double> getMovedPosition(Direction dir) const;
+        void prefetchNeighbours();
         void increaseDetail();
         void decreaseDetail();
         void zoom();
         void unzoom();
-        void takeScreen();
+        void takeScreen(bool highResolution);
+        void writeScreen(const std::string &fileName);
         void togglePanel();
         void toggleAutoAdjust();
+        void toggleDistanceEstimation();
+        void togglePalette();
+        void toggleJulia();
+        void cyclePower();
+        void goToNucleus();
         void refresh();
         void video();
+        void renderVideo(JobManifest &manifest);
+        void poster();
+        void dumpTrace();
 
+        bool isKeyHeld(sf::Keyboard::Key key) const;
         bool isControlKeyPressed() const;
         bool doAction() const;
 
@@ -66,6 +128,7 @@ class Application
         sf::RenderWindow& m_window;
         sf::Sprite m_fractaleSprite;
         Render m_fractaleRenderer;
+        Render::View m_mandelbrotView; // Where to come back from a Julia set
 
         sf::Font m_font;
         bool m_showText;
@@ -74,6 +137,10 @@ class Application
         sf::Sound m_sound;
         sf::SoundBuffer m_photoBuffer;
 
+        // Screenshots
+        ScreenshotQueue m_screenshots;
+        std::string m_pendingScreen; // Taken during a rendering, written at its end
+
         // Mouse
         bool m_isMousePressed;
         sf::Rect<int> m_mouseSelection;
@@ -83,6 +150,24 @@ class Application
         sf::Time m_lastTime;
         bool m_actionHappened;
         bool m_changeTexture;
+        bool m_needRedraw;
+        bool m_wasRenderingFinished;
+        bool m_viewShown;
+
+        // Keys held by simulateKey, read as the ones of the keyboard
+        std::vector<sf::Keyboard::Key> m_simulatedKeys;
+
+        // Frames of lower resolution while the navigation keys are held
+        ResolutionController m_resolution;
+        bool m_previewOutdated; // The view changed since the last one
+
+        // Info panels, laid out again only when their text changes
+        sf::Text m_infoText;
+        sf::Text m_zoomInfoText;
+        sf::RectangleShape m_infoBackground;
+        sf::RectangleShape m_zoomInfoBackground;
+        std::string m_infoString;
+        std::string m_zoomInfoString;
 };
 
 #endif // APPLICATION_H
@@ -0,0 +1,116 @@
+#ifndef DISTRIBUTEDRENDER_H
+#define DISTRIBUTEDRENDER_H
+
+// Std include
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Sfml include
+// - System
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Config.hpp> // For uint etc ...
+
+// Personal include
+#include "Snapshot.h"
+
+// Region of a view to compute, sent by a RenderCoordinator to a RenderWorker.
+// The messages are sent as they are in memory : the machines must share the byte order
+struct RenderJob
+{
+    sf::Uint32 magic;
+    sf::Uint32 id;
+    sf::Uint32 precision; // Snapshot::Precision
+    sf::Uint32 detailLevel;
+    sf::Uint32 imageWidth;
+    sf::Uint32 imageHeight;
+    sf::Uint32 originX;
+    sf::Uint32 originY;
+    sf::Uint32 regionWidth;
+    sf::Uint32 regionHeight;
+    double zoom;
+    double positionX;
+    double positionY;
+    sf::Uint32 formulaKind; // Formula::Kind
+    sf::Uint32 formulaPower;
+    double juliaReal;
+    double juliaImag;
+};
+
+// Process computing the jobs of the coordinators connected to its port, with the kernel of Render.
+// There is no authentication : it listens on the loopback unless it is given the address of a trusted network,
+// and refuses the jobs which are malformed or larger than maximumJobPixels
+class RenderWorker
+{
+public:
+    // Pixels of the region of a job, its iterations take 4 bytes each
+    static constexpr std::size_t maximumJobPixels = 1 << 26;
+
+    explicit RenderWorker(const unsigned threadCount);
+
+    RenderWorker(const RenderWorker& ) = delete;
+
+    // Blockant, serve the coordinators one after the other, on the IPv4 address bindAddress.
+    // Returns false if the address is invalid or the port can't be opened
+    bool serve(const unsigned short port, const std::string &bindAddress = "127.0.0.1");
+
+private:
+    bool handleConnection(const int connection);
+    static bool isValid(const RenderJob &job);
+    template <typename T>
+    void renderWith(const RenderJob &job);
+
+    FrameVector<unsigned> m_iterations;
+    unsigned m_threadCount;
+    bool m_isRunning;
+    sf::Mutex m_mutex;
+};
+
+// Cut the regions to compute in jobs of some rows and dispatch them to workers.
+// When no job is left, the idle workers compute again the unfinished ones, the first result is kept :
+// a slow or stopped worker doesn't hold the rendering back
+class RenderCoordinator
+{
+public:
+    RenderCoordinator();
+
+    RenderCoordinator(const RenderCoordinator& ) = delete;
+
+    ~RenderCoordinator();
+
+    // "host:port" of each worker. Returns false if none of them can be reached
+    bool connect(const std::vector<std::string> &addresses);
+    std::size_t getWorkerCount() const noexcept;
+
+    // Escape iterations of the region of the view, as mandelbrotKernel.
+    // Returns false if all the workers were lost
+    bool render(const sf::Vector2u imageSize, const sf::Vector2u origin, const sf::Vector2u regionSize,
+                const double zoom, const sf::Vector2<double> normalizedPosition, const unsigned detailLevel,
+                const Formula &formula, const Snapshot::Precision precision, FrameVector<unsigned> &iterations);
+
+private:
+    struct Worker
+    {
+        int socket;
+        bool busy;
+        sf::Uint32 jobId;           // Job computed if busy
+        std::size_t received;       // Bytes of the answer received
+        std::vector<sf::Uint8> answer;
+    };
+
+    struct Job
+    {
+        RenderJob message;
+        unsigned copies; // Workers computing it
+        bool done;
+    };
+
+    bool dispatch(Worker &worker, std::vector<Job> &jobs, std::size_t &nextJob);
+    void disconnect(Worker &worker, std::vector<Job> &jobs, const sf::Uint32 firstJobId);
+
+    std::vector<Worker> m_workers;
+    sf::Uint32 m_nextJobId; // The ids aren't reused, so the late answers of a previous render are recognized
+};
+
+#endif // DISTRIBUTEDRENDER_H
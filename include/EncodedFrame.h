@@ -0,0 +1,53 @@
+#ifndef ENCODEDFRAME_H
+#define ENCODEDFRAME_H
+
+// Std include
+#include <vector>
+#include <cstddef>
+
+// Sfml include
+// - System
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Config.hpp> // For uint etc ...
+
+// Personal include
+#include "FrameAllocator.h"
+
+// Side of the square tiles encoded apart
+constexpr unsigned encodedTileSize = 32;
+
+// Escape iterations of a frame kept out of the rendering, in a fraction of their size.
+// Each tile holds the offsets of its pixels from its smallest iteration, in the fewest bits
+// among 4, 8, 16 or 32; the highest code of the width stands for interiorIteration.
+// A solid tile, all inside the set or all escaping at once, only keeps its iteration
+class EncodedFrame
+{
+public:
+    EncodedFrame();
+    EncodedFrame(const FrameVector<unsigned> &iterations, const sf::Vector2u size, const unsigned threadCount = 8);
+
+    // Resize iterations to the frame and write it, on threadCount threads as the encoding
+    void decode(FrameVector<unsigned> &iterations, const unsigned threadCount = 8) const;
+
+    // Memory of the frame, tiles and codes
+    std::size_t getByteSize() const noexcept;
+
+private:
+    struct Tile
+    {
+        std::size_t offset; // Of its codes, in the array of their width
+        unsigned base;      // Smallest iteration, or the iteration of a solid tile
+        unsigned bits;      // 0 if solid
+    };
+
+    // Pixels of the tile t, at (x0, y0) of size width * height
+    void tileRect(const unsigned t, unsigned &x0, unsigned &y0, unsigned &width, unsigned &height) const noexcept;
+
+    sf::Vector2u m_size;
+    std::vector<Tile> m_tiles;
+    std::vector<sf::Uint8> m_codes8; // Two codes of 4 bits by byte, or one of 8
+    std::vector<sf::Uint16> m_codes16;
+    std::vector<sf::Uint32> m_codes32;
+};
+
+#endif // ENCODEDFRAME_H
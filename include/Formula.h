@@ -0,0 +1,42 @@
+#ifndef FORMULA_H
+#define FORMULA_H
+
+// Std include
+#include <algorithm>
+
+// Highest power of z of the compiled formulas
+constexpr unsigned maximumFormulaPower = 4;
+
+// Iterated formula of a view, chosen at runtime : z^power + c from z = 0 with c the pixel
+// ( Mandelbrot for the power 2, Multibrot above ), or from z = the pixel with a fixed c ( Julia ).
+// The kernel runs the policy compiled for it, see MultibrotPolicy and JuliaPolicy
+struct Formula
+{
+    enum class Kind{
+        Mandelbrot,
+        Julia
+    };
+
+    Formula(const Kind kind_ = Kind::Mandelbrot, const unsigned power_ = 2,
+            const double juliaReal_ = 0, const double juliaImag_ = 0):
+        kind(kind_), power(std::max(2u, std::min(power_, maximumFormulaPower))),
+        juliaReal(juliaReal_), juliaImag(juliaImag_)
+    {}
+
+    // The conjugate of a point has the conjugate orbit
+    bool isSymmetric() const { return kind == Kind::Mandelbrot || juliaImag == 0; }
+
+    bool operator==(const Formula &other) const
+    {
+        return kind == other.kind && power == other.power
+               && (kind == Kind::Mandelbrot || (juliaReal == other.juliaReal && juliaImag == other.juliaImag));
+    }
+    bool operator!=(const Formula &other) const { return !(*this == other); }
+
+    Kind kind;
+    unsigned power;
+    double juliaReal;
+    double juliaImag;
+};
+
+#endif // FORMULA_H
@@ -0,0 +1,97 @@
+#ifndef FRAMEALLOCATOR_H
+#define FRAMEALLOCATOR_H
+
+// Std include
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <new>
+
+// Posix include
+#include <sched.h>
+
+// Blocks from this size are mapped aligned on transparent huge pages
+constexpr std::size_t hugePageSize = 2 << 20;
+
+// Placement of the threads of the parallel regions ( kernel, colouring, first touch of the frames )
+// on the NUMA nodes. The pages of a frame are touched first by the threads of such a region,
+// by equal consecutive parts : bound the same way, each thread then writes its part on its own node.
+// Set by the environment variable MANDELBROT_AFFINITY :
+//   none     the system moves the threads ( default )
+//   spread   thread i of n on the node i * nodes / n
+//   node:N   every thread on the node N
+class ThreadPlacement
+{
+public:
+    enum class Mode{
+        None,
+        Spread,
+        Node
+    };
+
+    // Returns false if the value isn't one of the modes, the placement is then unchanged
+    static bool configure(const std::string &value);
+    static Mode getMode() noexcept;
+    static unsigned getNodeCount();
+
+    // Bind the calling thread of an OpenMP team. Does nothing in the mode None, or on a single node.
+    // The thread starting the team is its thread 0, a TeamScope gives it back its own placement
+    static void bindTeamThread();
+
+    // Made before a parallel region whose threads are bound, restores the affinity of the calling thread
+    // at its destruction. The UI or render thread isn't left on the node of the thread 0
+    class TeamScope
+    {
+    public:
+        TeamScope();
+        TeamScope(const TeamScope& ) = delete;
+        ~TeamScope();
+
+    private:
+        cpu_set_t m_cpus;
+        int m_boundNode;
+        bool m_restore;
+    };
+};
+
+// Memory of the big buffers : huge pages and, when the threads are placed, first touch spread over them
+// as above. The memory is zero-filled
+void* allocateFrameMemory(const std::size_t bytes);
+void freeFrameMemory(void* memory, const std::size_t bytes) noexcept;
+
+// Allocator of the frame, iteration, orbit and cache buffers. The small ones come from new
+template <typename T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    FrameAllocator() noexcept {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& ) noexcept {}
+
+    T* allocate(const std::size_t n)
+    {
+        if(n * sizeof(T) < hugePageSize)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(allocateFrameMemory(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, const std::size_t n) noexcept
+    {
+        if(n * sizeof(T) < hugePageSize)
+            ::operator delete(p);
+        else
+            freeFrameMemory(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>& , const FrameAllocator<U>& ) noexcept { return true; }
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>& , const FrameAllocator<U>& ) noexcept { return false; }
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif // FRAMEALLOCATOR_H
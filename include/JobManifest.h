@@ -0,0 +1,39 @@
+#ifndef JOBMANIFEST_H
+#define JOBMANIFEST_H
+
+// Std include
+#include <map>
+#include <string>
+
+// Personal include
+#include "Formula.h"
+
+// Parameters and progress of a long job ( video, poster ), saved as "key value" lines.
+// The file is replaced atomically and synced to the disk : a killed job or a power loss leaves
+// either the previous manifest or the new one. The output it counts on must be synced before, see syncFile
+class JobManifest
+{
+public:
+    JobManifest();
+
+    bool load(const std::string &fileName);
+    bool save(const std::string &fileName) const;
+
+    // Blockant, until the content of the file is on the disk
+    static bool syncFile(const std::string &fileName);
+
+    void set(const std::string &key, const std::string &value);
+    void setNumber(const std::string &key, const double value);
+
+    std::string get(const std::string &key) const; // Empty if missing
+    double getNumber(const std::string &key, const double defaultValue = 0) const;
+
+    // The formula of the view, the Mandelbrot set for the manifests without one
+    void setFormula(const Formula &formula);
+    Formula getFormula() const;
+
+private:
+    std::map<std::string, std::string> m_values;
+};
+
+#endif // JOBMANIFEST_H
@@ -0,0 +1,79 @@
+#ifndef LATENCYHARNESS_H
+#define LATENCYHARNESS_H
+
+// Std include
+#include <vector>
+#include <string>
+#include <ostream>
+
+// Sfml include
+// - Graphics
+#include <SFML/Graphics/RenderWindow.hpp>
+
+// - Window
+#include <SFML/Window/Event.hpp>
+
+// - System
+#include <SFML/System/Time.hpp>
+
+// Personal include
+#include "Application.h"
+
+// Replay a script of inputs through an Application, and measure for each one the time until
+// the window shows a first frame of the new view ( preview ), then its finished rendering ( final ).
+// The key of a burst is held until its last press, as a user would, so only the last one has a final.
+// A script has one command by line, '#' starts a comment :
+//   zoom N              Z held, N presses
+//   unzoom N            S held, N presses
+//   pan left|right|up|down N
+//   detail N            A held N presses, or Q if N is negative
+//   box X Y WIDTH HEIGHT  mouse selection, only drawn as the view doesn't change
+//   screenshot [large]  E, or Shift + E
+//   wait MS             pause before the next input, time left to the prefetch
+class LatencyHarness
+{
+public:
+    LatencyHarness(sf::RenderWindow &window, Application &application);
+
+    LatencyHarness(const LatencyHarness& ) = delete;
+
+    // Returns false if the file can't be read or has an unknown command
+    bool loadScript(const std::string &fileName);
+    // Zoom runs, pan bursts and detail changes, when no script is given
+    void loadDefaultScript();
+
+    // Blockant, until the last input is rendered or the window is closed
+    void run();
+
+    // Percentiles of the latencies in milliseconds, by kind of input
+    void printReport(std::ostream &output) const;
+
+private:
+    struct Step
+    {
+        std::string kind; // Command of the script
+        std::vector<sf::Event> events;
+        sf::Time pause;   // Before the events
+        sf::Keyboard::Key heldKey; // Unknown if none
+        bool release;     // Last press of the burst
+    };
+
+    struct Measure
+    {
+        std::string kind;
+        double preview; // Milliseconds
+        double final;   // Negative while the key is still held
+    };
+
+    bool parseLine(const std::string &line);
+    void addKeySteps(const std::string &kind, const sf::Keyboard::Key key, const unsigned count);
+    Measure runStep(const Step &step);
+
+    sf::RenderWindow& m_window;
+    Application& m_application;
+    std::vector<Step> m_steps;
+    std::vector<Measure> m_measures;
+    sf::Time m_nextPause;
+};
+
+#endif // LATENCYHARNESS_H
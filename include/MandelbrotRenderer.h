@@ -4,33 +4,226 @@
 // Std include
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <mutex>
+#include <quadmath.h>
 
 // Sfml include
 // - System
 #include <SFML/System/Vector2.hpp>
 #include <SFML/System/Mutex.hpp>
+#include <SFML/System/Sleep.hpp>
 #include <SFML/Config.hpp> // For uint etc ...
 
 // Gmp include
 #include <gmpxx.h>
 
-void mandelbrotRenderer(std::vector<sf::Uint8> &data, const sf::Vector2u& dataSize, const double zoom,
-                        const unsigned detailLevel, const sf::Vector2<double>& normalizedPosition, bool& isRunning, bool &finished);
+// Personal include
+#include "Trace.h"
+#include "Formula.h"
+#include "FrameAllocator.h"
 
-void gmp_mandelbrotRenderer(std::vector<sf::Uint8> &data, const sf::Vector2u& dataSize, const double zoom,
-                            const unsigned detailLevel, const sf::Vector2<double>& normalizedPosition, bool& isRunning, bool &finished);
+// Below this detail level, tracking the derivative costs more than it saves
+constexpr unsigned interiorCheckMinimumDetail = 64;
 
-template<typename T>
-unsigned getEscapeIterationFor(sf::Uint64 fractal_x, sf::Uint64 fractal_y, T zoom_x, T zoom_y,
-                               const unsigned detailLevel)
+// |dz/dz1|^2 under which the orbit is considered attracted by a cycle
+constexpr double interiorDerivativeThreshold = 1e-20;
+
+// Iteration count kept for the points proven to be inside the set,
+// unlike detailLevel, which only says the point didn't escape yet
+constexpr unsigned interiorIteration = static_cast<unsigned>(-1);
+
+// Side of the square tiles walked by mandelbrotKernel. The tile-local buffers
+// ( 32*32 iterations, orbits and distances ) stay in L1 for float and double, in L2 for __float128
+constexpr unsigned kernelTileSize = 32;
+
+// Threads of the kernel, unless the caller gives it less
+constexpr unsigned kernelThreadCount = 8;
+
+// The cost of a tile is estimated by blocks of this side, from one probed pixel
+// in each block, unless the previous iterations of the view are known
+constexpr unsigned kernelProbeBlockSize = kernelTileSize / 2;
+
+// A tile costing more than this fraction of the share of a thread is computed by blocks,
+// so no thread is left with a long tile at the end of the rendering
+constexpr double kernelSplitShare = 0.25;
+
+// What the kernel needs to know of a number type
+template <typename T>
+struct NumberTraits
+{
+    // Type in which the pixel positions are computed before being converted to T
+    typedef T Coordinate;
+    // Type of the derivatives, which only need a rough magnitude
+    typedef T Derivative;
+
+    static void setPrecision(unsigned) {}
+    static Coordinate make(double value) { return static_cast<Coordinate>(value); }
+    static Coordinate floor(const Coordinate &value) { return std::floor(value); }
+    static T fromCoordinate(const Coordinate &value) { return static_cast<T>(value); }
+    static Derivative toDerivative(const T &value) { return value; }
+    static double toDouble(const Coordinate &value) { return static_cast<double>(value); }
+};
+
+// The positions of the float pixels are computed in double, so the mirrored rows stay exact
+template <>
+struct NumberTraits<float>
+{
+    typedef double Coordinate;
+    typedef float Derivative;
+
+    static void setPrecision(unsigned) {}
+    static Coordinate make(double value) { return value; }
+    static Coordinate floor(const Coordinate &value) { return std::floor(value); }
+    static float fromCoordinate(const Coordinate &value) { return static_cast<float>(value); }
+    static Derivative toDerivative(const float &value) { return value; }
+    static double toDouble(const Coordinate &value) { return value; }
+};
+
+template <>
+struct NumberTraits<__float128>
+{
+    typedef __float128 Coordinate;
+    typedef double Derivative;
+
+    static void setPrecision(unsigned) {}
+    static Coordinate make(double value) { return value; }
+    static Coordinate floor(const Coordinate &value) { return floorq(value); }
+    static __float128 fromCoordinate(const Coordinate &value) { return value; }
+    static Derivative toDerivative(const __float128 &value) { return static_cast<double>(value); }
+    static double toDouble(const Coordinate &value) { return static_cast<double>(value); }
+};
+
+template <>
+struct NumberTraits<mpf_class>
+{
+    typedef mpf_class Coordinate;
+    typedef double Derivative;
+
+    // mpf_class takes the precision of its operands, or this one when built from a number.
+    // It is global to GMP, so it must be set before any mpf_class of the rendering is built
+    static void setPrecision(unsigned bits) { mpf_set_default_prec(bits); }
+    static Coordinate make(double value) { return mpf_class(value); }
+    static Coordinate floor(const Coordinate &value) { return mpf_class(::floor(value)); }
+    static mpf_class fromCoordinate(const Coordinate &value) { return value; }
+    static Derivative toDerivative(const mpf_class &value) { return value.get_d(); }
+    static double toDouble(const Coordinate &value) { return value.get_d(); }
+};
+
+// Bits of mpf_class needed to tell the pixels apart at this zoom
+inline unsigned precisionForZoom(const double zoom, const unsigned height)
+{
+    return 64 + static_cast<unsigned>(std::max(0.0, std::log2(zoom * height)));
+}
+
+// The precision of GMP is global to the process : a thread holds this lock from its setPrecision
+// to its last mpf_class, so the renderings of two precisions, or two views, never overlap
+inline std::mutex& gmpPrecisionMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
 
+// Wait for the lock of the GMP precision while isRunning, false if stopped before it is free.
+// Polled, so that a stop doesn't wait for the thread holding it
+inline bool lockGmpPrecision(std::unique_lock<std::mutex> &lock, bool& isRunning, sf::Mutex &mut)
 {
-    constexpr static T fractal_left = -2.1;
-    constexpr static T fractal_bottom = -1.2;
+    while(!lock.try_lock())
+    {
+        mut.lock();
+        const bool run = isRunning;
+        mut.unlock();
+        if(!run)
+            return false;
+        sf::sleep(sf::milliseconds(5));
+    }
+    return true;
+}
 
-    T c_r = static_cast<T>(fractal_x) / static_cast<T>(zoom_x) + fractal_left;
-    T c_i = static_cast<T>(fractal_y) / static_cast<T>(zoom_y) + fractal_bottom;
+// Zooms of a screen-sized view from which the previous number type can't tell the pixels apart
+constexpr double doubleRenderBeginning = 2e4;
+constexpr double float128RenderBeginning = 1e13;
+constexpr double gmpRenderBeginning = 1e25;
 
+// Last z of an orbit which reached the detail level without escaping,
+// kept to continue the iteration when the detail level is raised
+template <typename T>
+struct OrbitState
+{
+    T z_r;
+    T z_i;
+};
+
+// z^Power, by squarings and products unrolled at compile time
+template <unsigned Power>
+struct ComplexPower
+{
+    template <typename U>
+    static void compute(const U &z_r, const U &z_i, U &p_r, U &p_i)
+    {
+        if(Power % 2 == 0)
+        {
+            U h_r, h_i;
+            ComplexPower<Power / 2>::compute(z_r, z_i, h_r, h_i);
+            p_r = h_r * h_r - h_i * h_i;
+            p_i = (h_r + h_r) * h_i;
+        }
+        else
+        {
+            U h_r, h_i;
+            ComplexPower<Power - 1>::compute(z_r, z_i, h_r, h_i);
+            p_r = h_r * z_r - h_i * z_i;
+            p_i = h_r * z_i + h_i * z_r;
+        }
+    }
+};
+
+template <>
+struct ComplexPower<1>
+{
+    template <typename U>
+    static void compute(const U &z_r, const U &z_i, U &p_r, U &p_i)
+    {
+        p_r = z_r;
+        p_i = z_i;
+    }
+};
+
+template <>
+struct ComplexPower<0>
+{
+    template <typename U>
+    static void compute(const U &, const U &, U &p_r, U &p_i)
+    {
+        p_r = 1;
+        p_i = 0;
+    }
+};
+
+// Compiled formulas. The pixel is c, the orbit starts from 0.
+// Only the Mandelbrot set has the cardioid and bulb test
+template <unsigned Power>
+struct MultibrotPolicy
+{
+    static constexpr unsigned power = Power;
+    static constexpr bool julia = false;
+    static constexpr bool hasCardioid = (Power == 2);
+};
+
+typedef MultibrotPolicy<2> MandelbrotPolicy;
+
+// The pixel is the start of the orbit, c is fixed
+template <unsigned Power>
+struct JuliaPolicy
+{
+    static constexpr unsigned power = Power;
+    static constexpr bool julia = true;
+    static constexpr bool hasCardioid = false;
+};
+
+template<typename T>
+bool isInMainCardioidOrBulb(const T &c_r, const T &c_i)
+{
     // Optimization accorded to
     //http://en.wikibooks.org/wiki/Fractals/Iterations_in_the_complex_plane/Mandelbrot_set#Cardioid_and_period-2_checking
     // Check if the point is in the main cardioid
@@ -40,110 +233,743 @@ unsigned getEscapeIterationFor(sf::Uint64 fractal_x, sf::Uint64 fractal_y, T zoo
     // And in period 2 if
     // (x+1)^2 + y^2 < 1/16
 
-    const auto q_ = (c_r - 0.25) * (c_r - 0.25) + c_i*c_i;
+    const T q_ = (c_r - 0.25) * (c_r - 0.25) + c_i*c_i;
+
+    return (q_ * (q_ + (c_r - 0.25 )) < 0.25*c_i*c_i) //q(q+(x-1/4)) < 1/4 * y^2
+        || ( (c_r+1) * (c_r +1) + c_i*c_i < 1.0/16);  // (x+1)^2 + y^2 < 1/16
+}
+
+// Iterate the orbit of the Policy from 'orbit', which is the state after i iterations
+// ( i = 0 : z = 0, or the pixel for a Julia set ), until it escapes or reaches detailLevel.
+// Returns the iteration count, or interiorIteration.
+// TrackDerivative enables the interior detection, EstimateDistance writes the exterior
+// distance estimate ( in fractal units ) of an escaping point in distance, 0 otherwise.
+// The distance needs a fresh orbit ( i = 0 )
+template<typename Policy, bool TrackDerivative, bool EstimateDistance, typename T>
+unsigned iterateOrbit(const T &c_r, const T &c_i, OrbitState<T>& orbit, unsigned i,
+                      const unsigned detailLevel, double &distance)
+{
+    typedef NumberTraits<T> Traits;
+    typedef typename Traits::Derivative Derivative;
+    constexpr unsigned power = Policy::power;
+
+    distance = 0;
+
+    T z_r = orbit.z_r;
+    T z_i = orbit.z_i;
+
+    if(!TrackDerivative && !EstimateDistance)
+    {
+        T zi2 = z_i * z_i;
+        T zr2 = z_r * z_r;
+
+        if(power == 2)
+        {
+            // The squares of the escape test are reused by the next iteration
+            do
+            {
+                z_i = (z_r + z_r) * z_i + c_i;
+                z_r = zr2 - zi2 + c_r;
+
+                zi2 = z_i * z_i;
+                zr2 = z_r * z_r;
 
-    if((q_ * (q_ + (c_r - 0.25 )) < 0.25*c_i*c_i) //q(q+(x-1/4)) < 1/4 * y^2
-        || ( (c_r+1) * (c_r +1) + c_i*c_i < 1/16)  // (x+1)^2 + y^2 < 1/16
-       )
-   {
-       return detailLevel;
-   }
+                i++;
+            }
+            while (zi2 + zr2 < 4 && i < detailLevel);
+        }
+        else
+        {
+            T p_r, p_i;
+            do
+            {
+                ComplexPower<power>::compute(z_r, z_i, p_r, p_i);
+                z_r = p_r + c_r;
+                z_i = p_i + c_i;
 
+                zi2 = z_i * z_i;
+                zr2 = z_r * z_r;
 
-    T z_r = 0;
-    T z_i = 0;
+                i++;
+            }
+            while (zi2 + zr2 < 4 && i < detailLevel);
+        }
+
+        orbit.z_r = z_r;
+        orbit.z_i = z_i;
+        return i;
+    }
+
+    // Same iteration, tracking the derivatives of the orbit, with g = power * z^(power-1) :
+    // dz = dz_n/dz_k = g * dz, goes to 0 when the orbit is attracted by a cycle ( interior ).
+    // For a Julia set, from k = 0 it is also the derivative of the exterior distance estimate,
+    // else the estimate uses dc = dz_n/dc = g * dc + 1.
+    // For the other sets, the first iteration is done by hand ( z_1 = c ), dz_n/dz_0 is always 0 since z_0 = 0.
+    // When resuming, dz restarts from the resumed z, which still collapses for an attracted orbit
+    if(!Policy::julia && i == 0)
+    {
+        z_r = c_r;
+        z_i = c_i;
+        i = 1;
+    }
 
     T zi2 = z_i * z_i;
     T zr2 = z_r * z_r;
+    T p_r, p_i;
 
-    unsigned i = 0;
-    do
+    Derivative dz_r = 1;
+    Derivative dz_i = 0;
+
+    Derivative dc_r = 1;
+    Derivative dc_i = 0;
+
+    while (zi2 + zr2 < 4 && i < detailLevel)
     {
-        z_i = (z_r + z_r) * z_i + c_i;
-        z_r = zr2 - zi2 + c_r;
+        Derivative g_r, g_i;
+        ComplexPower<power - 1>::compute(Traits::toDerivative(z_r), Traits::toDerivative(z_i), g_r, g_i);
+        g_r *= power;
+        g_i *= power;
+
+        if(EstimateDistance && !Policy::julia)
+        {
+            const Derivative tmp = g_r * dc_r - g_i * dc_i + 1;
+            dc_i = g_r * dc_i + g_i * dc_r;
+            dc_r = tmp;
+        }
+
+        if(TrackDerivative || (EstimateDistance && Policy::julia))
+        {
+            const Derivative tmp = g_r * dz_r - g_i * dz_i;
+            dz_i = g_r * dz_i + g_i * dz_r;
+            dz_r = tmp;
+        }
+
+        if(power == 2)
+        {
+            z_i = (z_r + z_r) * z_i + c_i;
+            z_r = zr2 - zi2 + c_r;
+        }
+        else
+        {
+            ComplexPower<power>::compute(z_r, z_i, p_r, p_i);
+            z_r = p_r + c_r;
+            z_i = p_i + c_i;
+        }
 
         zi2 = z_i * z_i;
         zr2 = z_r * z_r;
 
         i++;
+
+        if(TrackDerivative && zi2 + zr2 < 4 && dz_r * dz_r + dz_i * dz_i < interiorDerivativeThreshold)
+        {
+            return interiorIteration;
+        }
     }
-    while (zi2 + zr2 < 4 && i < detailLevel);
 
+    if(EstimateDistance && i < detailLevel)
+    {
+        // d = |z| * ln|z| / |dc|
+        const Derivative d_r = (Policy::julia ? dz_r : dc_r);
+        const Derivative d_i = (Policy::julia ? dz_i : dc_i);
+        const double z_norm  = std::sqrt(Traits::toDouble(zr2 + zi2));
+        const double d_norm = std::sqrt(static_cast<double>(d_r * d_r + d_i * d_i));
+        distance = z_norm * std::log(z_norm) / d_norm;
+    }
+
+    orbit.z_r = z_r;
+    orbit.z_i = z_i;
     return i;
 }
 
+// Escape iteration of the pixel p, detailLevel if it doesn't escape.
+// The constant c of a Julia set is ignored by the other policies
+template<typename Policy, typename T>
+unsigned getEscapeIterationFor(const T &p_r, const T &p_i, const T &julia_r, const T &julia_i, const unsigned detailLevel)
+{
+    if(Policy::hasCardioid && isInMainCardioidOrBulb(p_r, p_i))
+    {
+        return detailLevel;
+    }
+
+    const T& c_r = (Policy::julia ? julia_r : p_r);
+    const T& c_i = (Policy::julia ? julia_i : p_i);
+    OrbitState<T> orbit { p_r, p_i };
+    if(!Policy::julia)
+    {
+        orbit.z_r = p_r * 0;
+        orbit.z_i = p_i * 0;
+    }
+    double distance = 0;
+    const unsigned i = (detailLevel < interiorCheckMinimumDetail ?
+                        iterateOrbit<Policy, false, false>(c_r, c_i, orbit, 0, detailLevel, distance) :
+                        iterateOrbit<Policy, true, false>(c_r, c_i, orbit, 0, detailLevel, distance));
+
+    return (i == interiorIteration ? detailLevel : i);
+}
+
+// Position in the complex plane of the pixels of a region of a view.
+// The pixels are numbered from the origin of the region, of size regionSize,
+// inside the whole image of size dataSize
 template <typename T>
-void mandelbrotRendererPrimitive(std::vector<sf::Uint8> &data, const sf::Vector2u dataSize, const double zoom,
-                                 const unsigned detailLevel, const sf::Vector2<double> normalizedPosition, bool& isRunning, bool &finished, sf::Mutex &mut)
+class ViewGeometry
 {
-    mut.lock();
-    finished = false;
-    mut.unlock();
+public:
+    typedef NumberTraits<T> Traits;
+    typedef typename Traits::Coordinate Coordinate;
+
+    ViewGeometry(const sf::Vector2u dataSize, const double zoom, const sf::Vector2<double> normalizedPosition):
+        ViewGeometry(dataSize, zoom, normalizedPosition, sf::Vector2u(0, 0), dataSize)
+    {}
+
+    // The rows are mirrored only if the formula is symmetric
+    ViewGeometry(const sf::Vector2u dataSize, const double zoom, const sf::Vector2<double> normalizedPosition,
+                 const sf::Vector2u origin, const sf::Vector2u regionSize, const bool symmetric = true):
+        m_zoom(Traits::make(zoom) * dataSize.y / (fractal_top - fractal_bottom)),
+        m_base(), m_axisSum(Traits::make(zoom) * dataSize.y),
+        m_mirrorSum(0), m_useSymmetry(false), m_mayBeInCardioid(false)
+    {
+        TRACE_SPAN("view setup");
+
+        // Each pixel is on an integer position of a grid of zoom * dataSize points
+        const Coordinate fractal_width  = Traits::floor(Traits::make(zoom) * dataSize.x);
+        const Coordinate fractal_height = Traits::floor(Traits::make(zoom) * dataSize.y);
+
+        m_base.x = Traits::floor(fractal_width  * normalizedPosition.x - dataSize.x / 2) + origin.x;
+        m_base.y = Traits::floor(fractal_height * normalizedPosition.y - dataSize.y / 2) + origin.y;
+
+        // The set is symmetric about the real axis : c_i(y1) = -c_i(y2) when
+        // fractal_y1 + fractal_y2 = (fractal_top - fractal_bottom) * zoom_y = zoom * dataSize.y.
+        // When this sum isn't an integer, it is rounded : the rows are shifted by less than half a pixel
+        // so the mirrored rows fall exactly on the pixels. The shift only depends on the whole image,
+        // the regions of a poster or of the workers are shifted alike, whether they hold the axis or not
+        const Coordinate roundedAxisSum = Traits::floor(m_axisSum + 0.5);
+        const double mirrorSum = Traits::toDouble(roundedAxisSum - 2 * m_base.y);
+
+        if(symmetric)
+            m_axisSum = roundedAxisSum;
+        m_useSymmetry = symmetric && mirrorSum >= 0 && mirrorSum <= 2.0 * (regionSize.y - 1);
+        if(m_useSymmetry)
+            m_mirrorSum = static_cast<sf::Int64>(mirrorSum);
+
+        // The cardioid and the period 2 bulb are inside [-1.25; 0.375] x [-0.65; 0.65]
+        const double left   = Traits::toDouble(real(0));
+        const double right  = Traits::toDouble(real(regionSize.x - 1));
+        const double bottom = Traits::toDouble(imag(0));
+        const double top    = Traits::toDouble(imag(regionSize.y - 1));
+        m_mayBeInCardioid = right >= -1.25 && left <= 0.375 && top >= -0.65 && bottom <= 0.65;
+    }
 
-    constexpr static T fractal_left = -2.1;
-    constexpr static T fractal_bottom = -1.2;
-    constexpr static T fractal_top = 1.2;
+    T real(const unsigned x) const
+    {
+        return Traits::fromCoordinate((m_base.x + x) / m_zoom + fractal_left);
+    }
 
-    const T zoom_y = zoom * dataSize.y / (fractal_top - fractal_bottom);
-    const T zoom_x = zoom_y;
+    // From the axis, so a row and its mirror are exactly opposite and a region computes
+    // the same values for its rows as the whole image, mirrored or not
+    T imag(const unsigned y) const
+    {
+        return Traits::fromCoordinate((2 * (m_base.y + y) - m_axisSum) / (2 * m_zoom));
+    }
 
-    const sf::Uint64 fractal_width  = static_cast<sf::Uint64>(dataSize.x * zoom);
-    const sf::Uint64 fractal_height = static_cast<sf::Uint64>(dataSize.y * zoom);
+    // Row y is the mirror of row mirrorOf(y); only the one with the lowest index is computed
+    bool isMirrored(const unsigned y) const
+    {
+        const sf::Int64 mirror = m_mirrorSum - static_cast<sf::Int64>(y);
+        return m_useSymmetry && mirror >= 0 && mirror < static_cast<sf::Int64>(y);
+    }
 
-    const sf::Uint64 baseFractal_x = static_cast<sf::Uint64>(
-                                         static_cast<T>(fractal_width) * normalizedPosition.x - dataSize.x / 2);
-    const sf::Uint64 baseFractal_y = static_cast<sf::Uint64>(
-                                         static_cast<T>(fractal_height) * normalizedPosition.y - dataSize.y / 2);
+    unsigned mirrorOf(const unsigned y) const
+    {
+        return static_cast<unsigned>(m_mirrorSum - y);
+    }
 
-    bool run = true;
+    bool useSymmetry() const { return m_useSymmetry; }
+
+    // False when the cardioid and bulb test can't succeed anywhere in the view
+    bool mayBeInCardioid() const { return m_mayBeInCardioid; }
 
-    #pragma omp parallel for num_threads(8)
-    for(unsigned y = 0; y < dataSize.y; ++y)
+    // Size of a pixel in the complex plane
+    double pixelSize() const { return 1.0 / Traits::toDouble(m_zoom); }
+
+    // Normalized position of the views centered on this point, at any zoom
+    static sf::Vector2<double> normalizedPositionOf(const sf::Vector2u dataSize, const double real, const double imag)
     {
-        const sf::Uint64 fractal_y = baseFractal_y + y;
+        const double height = fractal_top - fractal_bottom;
+        return sf::Vector2<double>((real - fractal_left) * dataSize.y / (height * dataSize.x),
+                                   (imag - fractal_bottom) / height);
+    }
 
-        mut.lock();
-        if(!isRunning){
-            run = false;
-        }
-        mut.unlock();
+private:
+    constexpr static double fractal_left = -2.1;
+    constexpr static double fractal_bottom = -1.2;
+    constexpr static double fractal_top = 1.2;
+
+    const Coordinate m_zoom; // Same on both axis
+    sf::Vector2<Coordinate> m_base;
+    Coordinate m_axisSum; // Of the fractal y of two mirrored rows, twice the one of the real axis
+    sf::Int64 m_mirrorSum;
+    bool m_useSymmetry;
+    bool m_mayBeInCardioid;
+};
+
+// Part of the region computed at once by a thread of mandelbrotKernel : a tile, or a block of a heavy one
+struct KernelWorkItem
+{
+    unsigned x0;
+    unsigned y0;
+    unsigned width;
+    unsigned height;
+    double cost; // In iterations
+};
+
+// Tile-local buffers of mandelbrotKernel, copied to the frame once the tile is done
+template <typename T>
+struct KernelTile
+{
+    unsigned iterations[kernelTileSize * kernelTileSize];
+    OrbitState<T> orbits[kernelTileSize * kernelTileSize];
+    float distance[kernelTileSize * kernelTileSize];
+};
+
+// Output formats of mandelbrotKernel : what is kept of a tile, copied row by row
+
+// Only the escape iteration of each pixel
+template <typename T>
+struct IterationOutput
+{
+    static constexpr bool resumable = false;
+
+    FrameVector<unsigned> &iterations;
+
+    bool estimateDistance() const { return false; }
+
+    void loadRow(KernelTile<T> &, unsigned, unsigned, unsigned) const {}
+
+    void storeRow(const KernelTile<T> &tile, const unsigned tileRow, const unsigned pixel, const unsigned width)
+    {
+        const unsigned* row = tile.iterations + tileRow * kernelTileSize;
+        std::copy(row, row + width, iterations.begin() + pixel);
+    }
+
+    void mirrorRow(const unsigned from, const unsigned to, const unsigned width)
+    {
+        std::copy(iterations.begin() + from, iterations.begin() + from + width, iterations.begin() + to);
+    }
+};
+
+// The escape iteration, the last z of the unfinished orbits to resume them,
+// and the distance estimate in pixels if its buffer isn't empty
+template <typename T>
+struct ResumableOutput
+{
+    static constexpr bool resumable = true;
+
+    FrameVector<unsigned> &iterations;
+    FrameVector<OrbitState<T>> &orbits;
+    FrameVector<float> &distance;
+
+    bool estimateDistance() const { return !distance.empty(); }
 
-        for(unsigned x = 0; x < dataSize.x && run; ++x)
+    void loadRow(KernelTile<T> &tile, const unsigned tileRow, const unsigned pixel, const unsigned width) const
+    {
+        std::copy(iterations.begin() + pixel, iterations.begin() + pixel + width, tile.iterations + tileRow * kernelTileSize);
+        std::copy(orbits.begin() + pixel, orbits.begin() + pixel + width, tile.orbits + tileRow * kernelTileSize);
+    }
+
+    void storeRow(const KernelTile<T> &tile, const unsigned tileRow, const unsigned pixel, const unsigned width)
+    {
+        const unsigned offset = tileRow * kernelTileSize;
+        std::copy(tile.iterations + offset, tile.iterations + offset + width, iterations.begin() + pixel);
+        std::copy(tile.orbits + offset, tile.orbits + offset + width, orbits.begin() + pixel);
+        if(estimateDistance())
+            std::copy(tile.distance + offset, tile.distance + offset + width, distance.begin() + pixel);
+    }
+
+    // The orbit of conj(c) is the conjugate orbit
+    void mirrorRow(const unsigned from, const unsigned to, const unsigned width)
+    {
+        std::copy(iterations.begin() + from, iterations.begin() + from + width, iterations.begin() + to);
+        if(estimateDistance())
+            std::copy(distance.begin() + from, distance.begin() + from + width, distance.begin() + to);
+        for(unsigned x = 0; x < width; ++x)
         {
-            const sf::Uint64 fractal_x = baseFractal_x + x;
+            orbits[to + x].z_r =  orbits[from + x].z_r;
+            orbits[to + x].z_i = -orbits[from + x].z_i;
+        }
+    }
+};
+
+// The tiles of the region, the most expensive first, the heaviest ones cut in blocks.
+// The cost of a block is its number of unfinished pixels when the kernel resumes a rendering,
+// else it is guessed from the escape iteration of its center. The mirrored rows are free
+template <typename T, typename Policy, typename Output>
+std::vector<KernelWorkItem> scheduleTiles(const Output &output, const ViewGeometry<T> &geometry, const sf::Vector2u dataSize,
+                                          const unsigned detailLevel, const unsigned previousDetailLevel,
+                                          const T &julia_r, const T &julia_i, const unsigned threadCount)
+{
+    TRACE_SPAN("tile schedule");
 
-            unsigned i = 0;
+    const unsigned tilesPerRow = (dataSize.x + kernelTileSize - 1) / kernelTileSize;
+    const unsigned tileCount = tilesPerRow * ((dataSize.y + kernelTileSize - 1) / kernelTileSize);
+    constexpr unsigned blocksPerSide = kernelTileSize / kernelProbeBlockSize;
+    constexpr unsigned blocksPerTile = blocksPerSide * blocksPerSide;
 
-            i = getEscapeIterationFor(fractal_x, fractal_y, zoom_x, zoom_y, detailLevel);
+    std::vector<KernelWorkItem> blocks(tileCount * blocksPerTile, KernelWorkItem{0, 0, 0, 0, 0});
 
-            unsigned offset = (y * dataSize.x + x) * 4;
-            if (i == detailLevel)
+    #pragma omp parallel for num_threads(threadCount) schedule(dynamic)
+    for(unsigned t = 0; t < tileCount; ++t)
+    {
+        for(unsigned b = 0; b < blocksPerTile; ++b)
+        {
+            KernelWorkItem &block = blocks[t * blocksPerTile + b];
+            block.x0 = (t % tilesPerRow) * kernelTileSize + (b % blocksPerSide) * kernelProbeBlockSize;
+            block.y0 = (t / tilesPerRow) * kernelTileSize + (b / blocksPerSide) * kernelProbeBlockSize;
+            if(block.x0 >= dataSize.x || block.y0 >= dataSize.y)
+                continue;
+            block.width  = std::min(kernelProbeBlockSize, dataSize.x - block.x0);
+            block.height = std::min(kernelProbeBlockSize, dataSize.y - block.y0);
+
+            unsigned rows = 0;
+            double unfinished = 0;
+            for(unsigned y = block.y0; y < block.y0 + block.height; ++y)
             {
-                data[offset++] = static_cast<sf::Uint8>(0);
-                data[offset++] = static_cast<sf::Uint8>(0);
-                data[offset++] = static_cast<sf::Uint8>(0);
-                data[offset++] = static_cast<sf::Uint8>(255);
+                if(geometry.isMirrored(y))
+                    continue;
+                ++rows;
+                if(Output::resumable && previousDetailLevel != 0)
+                    unfinished += std::count(output.iterations.begin() + y * dataSize.x + block.x0,
+                                             output.iterations.begin() + y * dataSize.x + block.x0 + block.width,
+                                             previousDetailLevel);
+            }
+
+            // At least one iteration by pixel, even for the ones proven inside
+            if(Output::resumable && previousDetailLevel != 0){
+                block.cost = static_cast<double>(rows) * block.width + unfinished * (detailLevel - previousDetailLevel);
+            }else if(rows > 0){
+                const unsigned i = getEscapeIterationFor<Policy>(geometry.real(block.x0 + block.width / 2),
+                                                                 geometry.imag(block.y0 + block.height / 2),
+                                                                 julia_r, julia_i, detailLevel);
+                block.cost = static_cast<double>(rows) * block.width * std::max(1u, i);
             }
-            else
+        }
+    }
+
+    double totalCost = 0;
+    for(const KernelWorkItem& block : blocks)
+        totalCost += block.cost;
+    const double splitCost = totalCost / threadCount * kernelSplitShare;
+
+    std::vector<KernelWorkItem> schedule;
+    schedule.reserve(blocks.size());
+    for(unsigned t = 0; t < tileCount; ++t)
+    {
+        const KernelWorkItem* tileBlocks = &blocks[t * blocksPerTile];
+        KernelWorkItem tile { tileBlocks[0].x0, tileBlocks[0].y0,
+                              std::min(kernelTileSize, dataSize.x - tileBlocks[0].x0),
+                              std::min(kernelTileSize, dataSize.y - tileBlocks[0].y0), 0 };
+        for(unsigned b = 0; b < blocksPerTile; ++b)
+            tile.cost += tileBlocks[b].cost;
+
+        if(tile.cost > splitCost){
+            for(unsigned b = 0; b < blocksPerTile; ++b){
+                if(tileBlocks[b].width > 0 && tileBlocks[b].height > 0)
+                    schedule.push_back(tileBlocks[b]);
+            }
+        }else{
+            schedule.push_back(tile);
+        }
+    }
+
+    // The equal costs keep the order of the rows, for the caches
+    std::stable_sort(schedule.begin(), schedule.end(),
+                     [](const KernelWorkItem& a, const KernelWorkItem& b){ return a.cost > b.cost; });
+    return schedule;
+}
+
+// Compiled for each formula, limit class and early-out check, see mandelbrotKernel
+template <typename T, typename Policy, typename Output, bool CheckCardioid, bool TrackDerivative, bool EstimateDistance>
+bool mandelbrotTiles(Output &output, const ViewGeometry<T> &geometry, const sf::Vector2u dataSize,
+                     const std::vector<KernelWorkItem> &schedule,
+                     const unsigned detailLevel, const unsigned previousDetailLevel,
+                     const T &julia_r, const T &julia_i, bool& isRunning, sf::Mutex &mut,
+                     const unsigned threadCount)
+{
+    const unsigned itemCount = schedule.size();
+    const double pixelSize = geometry.pixelSize();
+
+    bool run = true;
+
+    const ThreadPlacement::TeamScope scope;
+    #pragma omp parallel num_threads(threadCount)
+    {
+        ThreadPlacement::bindTeamThread();
+
+        // Reused by all the tiles of the thread. The position of the pixels
+        KernelTile<T> tile;
+        T c_r[kernelTileSize];
+        T c_i[kernelTileSize];
+
+        // Given in the order of the schedule, so the heaviest tiles are started first
+        #pragma omp for schedule(dynamic)
+        for(unsigned t = 0; t < itemCount; ++t)
+        {
+            mut.lock();
+            if(!isRunning){
+                run = false;
+            }
+            mut.unlock();
+
+            if(!run)
+                continue;
+
+            TRACE_SPAN_ARG("tile", t);
+
+            const unsigned x0 = schedule[t].x0;
+            const unsigned y0 = schedule[t].y0;
+            const unsigned width  = schedule[t].width;
+            const unsigned height = schedule[t].height;
+
+            for(unsigned col = 0; col < width; ++col)
+                c_r[col] = geometry.real(x0 + col);
+            for(unsigned row = 0; row < height; ++row)
+                c_i[row] = geometry.imag(y0 + row);
+
+            for(unsigned row = 0; row < height; ++row)
             {
-                const double t = static_cast<double>(i)/static_cast<double>(detailLevel);
+                // A tile takes long in GMP at high detail levels, a stop is checked on each row too
+                mut.lock();
+                if(!isRunning){
+                    run = false;
+                }
+                mut.unlock();
+
+                if(!run)
+                    break;
+                if(geometry.isMirrored(y0 + row))
+                    continue;
+
+                if(Output::resumable && previousDetailLevel != 0)
+                    output.loadRow(tile, row, (y0 + row) * dataSize.x + x0, width);
+
+                for(unsigned col = 0; col < width; ++col)
+                {
+                    const unsigned p = row * kernelTileSize + col;
+                    OrbitState<T> &orbit = tile.orbits[p];
+                    unsigned i = 0;
+                    double pixelDistance = 0;
+
+                    // The c of the formula
+                    const T &k_r = (Policy::julia ? julia_r : c_r[col]);
+                    const T &k_i = (Policy::julia ? julia_i : c_i[row]);
+
+                    if(Output::resumable && previousDetailLevel != 0)
+                    {
+                        // Escaped or proven interior pixels keep their count. A pixel which escaped
+                        // on its last allowed iteration also stopped at previousDetailLevel, its orbit tells it apart
+                        i = tile.iterations[p];
+                        if(i == previousDetailLevel && orbit.z_r * orbit.z_r + orbit.z_i * orbit.z_i < 4)
+                            i = iterateOrbit<Policy, TrackDerivative, false>(k_r, k_i, orbit, i, detailLevel, pixelDistance);
+                    }
+                    else if(CheckCardioid && isInMainCardioidOrBulb(c_r[col], c_i[row]))
+                    {
+                        i = interiorIteration;
+                    }
+                    else
+                    {
+                        if(Policy::julia){
+                            orbit.z_r = c_r[col];
+                            orbit.z_i = c_i[row];
+                        }else{
+                            orbit.z_r = 0;
+                            orbit.z_i = 0;
+                        }
+                        i = iterateOrbit<Policy, TrackDerivative, EstimateDistance>(k_r, k_i, orbit, 0, detailLevel, pixelDistance);
+                    }
+
+                    tile.iterations[p] = i;
+                    if(EstimateDistance)
+                        tile.distance[p] = static_cast<float>(pixelDistance / pixelSize); // Fractal units to pixels
+                }
+
+                output.storeRow(tile, row, (y0 + row) * dataSize.x + x0, width);
+            }
+        }
+    }
+
+    // Copy the mirrored rows
+    if(geometry.useSymmetry() && run)
+    {
+        TRACE_SPAN("mirror rows");
+
+        #pragma omp parallel for num_threads(threadCount)
+        for(unsigned y = 0; y < dataSize.y; ++y)
+        {
+            if(geometry.isMirrored(y))
+                output.mirrorRow(geometry.mirrorOf(y) * dataSize.x, y * dataSize.x, dataSize.x);
+        }
+    }
+
+    return run;
+}
+
+// The kernel of a compiled formula, see mandelbrotKernel
+template <typename T, typename Policy, typename Output>
+bool formulaKernel(Output &output, const ViewGeometry<T> &geometry, const sf::Vector2u regionSize,
+                   const unsigned detailLevel, const unsigned previousDetailLevel,
+                   const T &julia_r, const T &julia_i, bool& isRunning, sf::Mutex &mut, const unsigned threadCount)
+{
+    // The specializations : the derivative only pays at high detail levels,
+    // the cardioid test only if the view crosses it
+    const bool checkCardioid = Policy::hasCardioid && geometry.mayBeInCardioid();
+    const bool trackDerivative = detailLevel >= interiorCheckMinimumDetail;
+    const bool estimateDistance = output.estimateDistance() && previousDetailLevel == 0;
+
+    const std::vector<KernelWorkItem> schedule = scheduleTiles<T, Policy>(output, geometry, regionSize, detailLevel,
+                                                                          previousDetailLevel, julia_r, julia_i, threadCount);
+
+    #define MANDELBROT_TILES(cardioid, derivative, distance) \
+        mandelbrotTiles<T, Policy, Output, cardioid, derivative, distance>(output, geometry, regionSize, schedule, detailLevel, previousDetailLevel, julia_r, julia_i, isRunning, mut, threadCount)
+
+    if(estimateDistance)
+        return (checkCardioid ? MANDELBROT_TILES(true, true, true) : MANDELBROT_TILES(false, true, true));
+    if(trackDerivative)
+        return (checkCardioid ? MANDELBROT_TILES(true, true, false) : MANDELBROT_TILES(false, true, false));
+    return (checkCardioid ? MANDELBROT_TILES(true, false, false) : MANDELBROT_TILES(false, false, false));
+
+    #undef MANDELBROT_TILES
+}
+
+// Compute the escape iteration of each pixel of the region of the view in T, written through the Output format,
+// whose buffers have the size of the region. The region is walked by tiles of kernelTileSize,
+// each one computed in a tile-local buffer then copied once, in the order of scheduleTiles.
+// If previousDetailLevel isn't 0, a ResumableOutput holds a complete rendering of the
+// same view at this lower detail level : only its unfinished pixels are iterated further.
+// The formula runs the loop compiled for it, as fast as the one of the Mandelbrot set.
+// The colours are left to a Palette. Returns false if the rendering was stopped before the end
+template <typename T, typename Output>
+bool mandelbrotKernel(Output &output, const sf::Vector2u dataSize, const sf::Vector2u origin, const sf::Vector2u regionSize,
+                      const double zoom, const unsigned detailLevel, const unsigned previousDetailLevel,
+                      const sf::Vector2<double> normalizedPosition, const Formula &formula, bool& isRunning, sf::Mutex &mut,
+                      const unsigned threadCount = kernelThreadCount)
+{
+    TRACE_SPAN("kernel");
+
+    typedef NumberTraits<T> Traits;
+    Traits::setPrecision(precisionForZoom(zoom, dataSize.y));
+
+    const ViewGeometry<T> geometry(dataSize, zoom, normalizedPosition, origin, regionSize, formula.isSymmetric());
+    const T julia_r = Traits::fromCoordinate(Traits::make(formula.juliaReal));
+    const T julia_i = Traits::fromCoordinate(Traits::make(formula.juliaImag));
+
+    #define FORMULA_KERNEL(policy) \
+        formulaKernel<T, policy>(output, geometry, regionSize, detailLevel, previousDetailLevel, julia_r, julia_i, isRunning, mut, threadCount)
+
+    if(formula.kind == Formula::Kind::Julia)
+    {
+        switch(formula.power)
+        {
+            case 3  : return FORMULA_KERNEL(JuliaPolicy<3>);
+            case 4  : return FORMULA_KERNEL(JuliaPolicy<4>);
+            default : return FORMULA_KERNEL(JuliaPolicy<2>);
+        }
+    }
+    switch(formula.power)
+    {
+        case 3  : return FORMULA_KERNEL(MultibrotPolicy<3>);
+        case 4  : return FORMULA_KERNEL(MultibrotPolicy<4>);
+        default : return FORMULA_KERNEL(MandelbrotPolicy);
+    }
 
-                // Use smooth polynomials for r, g, b
-                sf::Uint8 r = static_cast<sf::Uint8>(9*(1-t)*t*t*t*255);
-                sf::Uint8 g = static_cast<sf::Uint8>(15*(1-t)*(1-t)*t*t*255);
-                sf::Uint8 b = static_cast<sf::Uint8>(8.5*(1-t)*(1-t)*(1-t)*t*255);
+    #undef FORMULA_KERNEL
+}
+
+// The whole view
+template <typename T, typename Output>
+bool mandelbrotKernel(Output &output, const sf::Vector2u dataSize, const double zoom,
+                      const unsigned detailLevel, const unsigned previousDetailLevel,
+                      const sf::Vector2<double> normalizedPosition, const Formula &formula, bool& isRunning, sf::Mutex &mut,
+                      const unsigned threadCount = kernelThreadCount)
+{
+    return mandelbrotKernel<T>(output, dataSize, sf::Vector2u(0, 0), dataSize, zoom, detailLevel, previousDetailLevel,
+                               normalizedPosition, formula, isRunning, mut, threadCount);
+}
 
-                data[offset++] = r;
-                data[offset++] = g;
-                data[offset++] = b;
-                data[offset++] = static_cast<sf::Uint8>(255);
+template <typename T, typename Policy>
+std::vector<unsigned> escapeIterationHistogramWith(const ViewGeometry<T> &geometry, const sf::Vector2u dataSize,
+                                                   const unsigned detailLevel, const T &julia_r, const T &julia_i,
+                                                   const unsigned step, bool& isRunning, sf::Mutex &mut)
+{
+    std::vector<unsigned> histogram(detailLevel + 1, 0);
+    bool run = true;
+
+    #pragma omp parallel num_threads(kernelThreadCount)
+    {
+        std::vector<unsigned> localHistogram(detailLevel + 1, 0);
+
+        #pragma omp for schedule(dynamic)
+        for(unsigned y = step / 2; y < dataSize.y; y += step)
+        {
+            mut.lock();
+            if(!isRunning){
+                run = false;
+            }
+            mut.unlock();
+
+            if(!run)
+                continue;
+
+            const T c_i = geometry.imag(y);
+            for(unsigned x = step / 2; x < dataSize.x; x += step)
+            {
+                ++localHistogram[getEscapeIterationFor<Policy>(geometry.real(x), c_i, julia_r, julia_i, detailLevel)];
             }
         }
+
+        #pragma omp critical
+        for(unsigned i = 0; i <= detailLevel; ++i)
+            histogram[i] += localHistogram[i];
+    }
+
+    if(!run)
+        histogram.clear();
+    return histogram;
+}
+
+// Escape iteration histogram of one pixel out of step in each direction,
+// histogram[detailLevel] counts the pixels which didn't escape. Empty if stopped by isRunning, checked between rows
+template <typename T>
+std::vector<unsigned> escapeIterationHistogram(const sf::Vector2u dataSize, const double zoom, const unsigned detailLevel,
+                                               const sf::Vector2<double> normalizedPosition, const Formula &formula,
+                                               const unsigned step, bool& isRunning, sf::Mutex &mut)
+{
+    typedef NumberTraits<T> Traits;
+    Traits::setPrecision(precisionForZoom(zoom, dataSize.y));
+
+    const ViewGeometry<T> geometry(dataSize, zoom, normalizedPosition);
+    const T julia_r = Traits::fromCoordinate(Traits::make(formula.juliaReal));
+    const T julia_i = Traits::fromCoordinate(Traits::make(formula.juliaImag));
+
+    #define FORMULA_HISTOGRAM(policy) \
+        escapeIterationHistogramWith<T, policy>(geometry, dataSize, detailLevel, julia_r, julia_i, step, isRunning, mut)
+
+    if(formula.kind == Formula::Kind::Julia)
+    {
+        switch(formula.power)
+        {
+            case 3  : return FORMULA_HISTOGRAM(JuliaPolicy<3>);
+            case 4  : return FORMULA_HISTOGRAM(JuliaPolicy<4>);
+            default : return FORMULA_HISTOGRAM(JuliaPolicy<2>);
+        }
+    }
+    switch(formula.power)
+    {
+        case 3  : return FORMULA_HISTOGRAM(MultibrotPolicy<3>);
+        case 4  : return FORMULA_HISTOGRAM(MultibrotPolicy<4>);
+        default : return FORMULA_HISTOGRAM(MandelbrotPolicy);
     }
 
-    mut.lock();
-    finished = true;
-    mut.unlock();
+    #undef FORMULA_HISTOGRAM
 }
 
 #endif // MANDELBROTRENDERER_H
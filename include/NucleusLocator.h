@@ -0,0 +1,35 @@
+#ifndef NUCLEUSLOCATOR_H
+#define NUCLEUSLOCATOR_H
+
+// Std include
+#include <limits>
+
+// Sfml include
+// - System
+#include <SFML/System/Vector2.hpp>
+
+// Center of the cardioid of a minibrot, where its orbit of period p comes back to 0
+struct Nucleus
+{
+    unsigned period;
+    sf::Vector2<double> position; // In the complex plane
+    // Complex : the minibrot is the whole set, scaled and turned by it around the nucleus
+    sf::Vector2<double> size;
+};
+
+// Deepest minibrot which can be shown : the position of a view is a double, it is 1 / 64 of the view
+// away at most from the nucleus up to this zoom. Deeper, the refinement would be lost
+constexpr double maximumMinibrotZoom = 1 / (64 * std::numeric_limits<double>::epsilon());
+
+// Find the nucleus of the lowest period in the disc around the view of a Render, for z^2 + c.
+// The period is the first iteration at which the image of the disc contains 0, then Newton's
+// method solves z_period(c) = 0 from the center of the view : in the number type of the view,
+// again in the one of the minibrot if it's deeper. Returns false if no period is found up to
+// maximumPeriod, if Newton doesn't converge inside the view, or if the minibrot is deeper than maximumMinibrotZoom
+bool locateNucleus(const sf::Vector2u dataSize, const double zoom, const sf::Vector2<double> normalizedPosition,
+                   const unsigned maximumPeriod, Nucleus &nucleus);
+
+// Zoom and normalized position showing the minibrot as the whole set is shown at zoom 1
+void nucleusView(const Nucleus &nucleus, const sf::Vector2u dataSize, double &zoom, sf::Vector2<double> &normalizedPosition);
+
+#endif // NUCLEUSLOCATOR_H
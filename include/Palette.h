@@ -0,0 +1,43 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+// Std include
+#include <vector>
+
+// Sfml include
+#include <SFML/Config.hpp> // For uint etc ...
+
+// Personal include
+#include "FrameAllocator.h"
+
+// Colour the escape iterations of a frame, through a table indexed by iteration
+class Palette
+{
+public:
+    enum class Mode{
+        Linear,             // t = iteration / detailLevel
+        HistogramEqualized  // t = fraction of the escaped pixels escaping before
+    };
+
+    Palette();
+
+    void setMode(Mode mode) noexcept;
+    Mode getMode() const noexcept;
+
+    // Write the RGBA colour of each pixel in data. If distance isn't empty,
+    // the pixels close to the boundary are lit up
+    void colorize(const FrameVector<unsigned> &iterations, const FrameVector<float> &distance,
+                  FrameVector<sf::Uint8> &data, const unsigned detailLevel);
+
+private:
+    void buildLinearTable(const unsigned detailLevel);
+    void buildEqualizedTable(const FrameVector<unsigned> &iterations, const unsigned detailLevel);
+    void setColor(const unsigned index, const double t);
+
+    // RGBA for each iteration, the last entry is for the pixels which didn't escape
+    std::vector<sf::Uint8> m_table;
+    unsigned m_tableDetailLevel; // 0 when the table must be rebuilt
+    Mode m_mode;
+};
+
+#endif // PALETTE_H
@@ -0,0 +1,68 @@
+#ifndef POSTER_H
+#define POSTER_H
+
+// Std include
+#include <vector>
+#include <string>
+
+// Sfml include
+// - System
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/Vector2.hpp>
+
+// Personal include
+#include "MandelbrotRenderer.h"
+#include "Palette.h"
+#include "Snapshot.h"
+#include "DistributedRender.h"
+
+// Render a view at a size too big for the memory, or for a texture, to a TIFF file.
+// The image is computed by horizontal bands, each one written as soon as it is coloured,
+// so the memory only depends on the width of the image
+class Poster
+{
+    FrameVector<unsigned> m_iterations;
+    FrameVector<sf::Uint8> m_data; // RGBA of the band
+    std::vector<sf::Uint8> m_rgb;
+    Palette m_palette;
+
+    sf::Vector2u m_size;
+    sf::Vector2<double> m_normalizedPosition;
+    double m_scale;
+    unsigned m_detailLevel;
+    Formula m_formula;
+
+    bool m_isRunning;
+    sf::Mutex m_mutex;
+    RenderCoordinator* m_coordinator; // Null to compute the bands here
+
+    Snapshot::Precision getPrecision() const noexcept;
+    unsigned getBandHeight() const noexcept;
+    bool renderFrom(const std::string &fileName, const unsigned firstBand);
+    bool renderBand(const unsigned firstRow, const unsigned rows);
+    template <typename T>
+    void renderBandWith(const unsigned firstRow, const unsigned rows);
+
+public:
+    // The view is the one of a Render, at any size
+    Poster(const sf::Vector2u size, const double zoom, const sf::Vector2<double> normalizedPosition,
+           const unsigned detailLevel, const Formula &formula = Formula());
+
+    Poster(const Poster& ) = delete;
+
+    // Compute the bands on the workers of the coordinator
+    void setCoordinator(RenderCoordinator* coordinator) noexcept;
+
+    // Blockant, returns false if the file couldn't be written.
+    // The progress is saved after each band in the job manifest fileName + ".job", removed at the end
+    bool render(const std::string &fileName);
+    // Blockant, the RGBA of the whole image instead of a file, for the sizes which fit in memory
+    bool renderPixels(std::vector<sf::Uint8> &pixels);
+
+    sf::Vector2u getSize() const noexcept;
+
+    // Finish the poster of a manifest left by a stopped render
+    static bool resume(const std::string &manifestName, RenderCoordinator* coordinator = nullptr);
+};
+
+#endif // POSTER_H
@@ -3,6 +3,11 @@
 
 // Std include
 #include <vector>
+#include <list>
+#include <cstddef>
+#include <string>
+#include <mutex>
+#include <condition_variable>
 
 // Sfml include
 // - Graphics
@@ -12,39 +17,126 @@
 #include <SFML/System/Thread.hpp>
 #include <SFML/System/Mutex.hpp>
 #include <SFML/System/Vector2.hpp>
+#include <SFML/System/Time.hpp>
 
 // Gmp include
 #include <gmpxx.h>
 
 // Personal include
 #include "RenderThread.h"
+#include "MandelbrotRenderer.h"
+#include "Palette.h"
+#include "Snapshot.h"
+#include "FrameAllocator.h"
+#include "NucleusLocator.h"
+#include "EncodedFrame.h"
 
 typedef double real;
 
 class Render
 {
-    std::vector<sf::Uint8> m_data;
+public:
+    enum class DetailMode{
+        Manual,    // Only changed by setDetailLevel
+        Zoom,      // Fixed formula of the zoom
+        Histogram  // Smallest limit resolving the escape histogram of a preview pass
+    };
+
+    // A view which may be asked next, computed in the background when the renderer is idle
+    struct View
+    {
+        double scale;
+        sf::Vector2<double> normalizedPosition;
+    };
+
+private:
+    // Iterations of a complete frame, computed ahead or rendered before
+    struct CachedView
+    {
+        double scale;
+        sf::Vector2<double> normalizedPosition;
+        unsigned detailLevel;
+        EncodedFrame frame;
+    };
+
+    // The view of the frame in m_iterations, to know if it can be resumed
+    struct RenderedView
+    {
+        double scale;
+        sf::Vector2<double> normalizedPosition;
+        unsigned detailLevel; // 0 if no complete frame can be resumed
+    };
+
+    FrameVector<sf::Uint8> m_data;
+    FrameVector<unsigned> m_iterations;
+    FrameVector<float> m_distance; // Exterior distance estimate in pixels, empty if disabled
+    // Last z of the unfinished pixels, only the one of the current precision is used
+    FrameVector<OrbitState<float>> m_floatOrbits;
+    FrameVector<OrbitState<double>> m_doubleOrbits;
+    FrameVector<OrbitState<__float128>> m_float128Orbits;
+    FrameVector<OrbitState<mpf_class>> m_gmpOrbits;
+    RenderedView m_renderedView;
+    Palette m_palette;
     sf::Vector2u m_imageSize;
     sf::Texture m_texture;
     bool m_isRenderingFinished;
 
+    // Lower resolution frame of the view, shown while it is moved. Its texture has the full size,
+    // the frame is in its top left corner
+    FrameVector<unsigned> m_previewIterations;
+    FrameVector<sf::Uint8> m_previewData;
+    sf::Texture m_previewTexture;
+    bool m_previewRun; // Cleared at the deadline of the preview
+
     sf::Vector2<double> m_normalizedPosition;
     sf::Vector2<mpf_class> m_gmp_normalizedPosition;
     double m_scale;
     unsigned m_detailLevel;
-    bool m_autoAdjustDetail;
+    DetailMode m_detailMode;
+    bool m_histogramDetailValid; // False when the view changed since the last preview pass
+    bool m_estimateDistance;
+    Formula m_formula;
 
     sf::Thread m_renderThread;
     bool m_threadRun;
 
+    // Only used while no rendering runs, the real ones stop the prefetch before starting
+    std::list<CachedView> m_cache; // Most recently used first
+    std::vector<CachedView> m_prefetchQueue;
+    FrameVector<unsigned> m_prefetchIterations; // Of the view being computed ahead, before its encoding
+    sf::Thread m_prefetchThread;
+    bool m_prefetchRun;
+    unsigned m_prefetchThreadCount;
+    std::size_t m_cacheBudget; // Bytes
+
     sf::Mutex m_mutexForBoolean;
 
+    // Wakes up the threads waiting for the end of a rendering
+    std::mutex m_finishedMutex;
+    std::condition_variable m_renderingFinished;
+
     void launchRendering() noexcept;
+    template <typename T>
+    void launchRenderingWith(FrameVector<OrbitState<T>> &orbits) noexcept;
 
     void launchAllThread();
     void terminateAllThread();
 
+    void launchPrefetch() noexcept;
+    template <typename T>
+    bool prefetchWith(CachedView &view);
+    template <typename T>
+    bool previewWith(const sf::Vector2u size);
+    std::list<CachedView>::iterator findInCache(double scale, sf::Vector2<double> normalizedPosition, unsigned detailLevel);
+    void stopPrefetch();
+    bool loadFromCache();
+    void storeInCache(CachedView &&view);
+    void shrinkCache();
+
     unsigned getDetailForZoom(double zoom) const;
+    // 0 if the rendering is stopped during the probe
+    unsigned getDetailFromHistogram();
+    std::vector<unsigned> probeEscapeHistogram(unsigned probeLimit);
 
 public:
 
@@ -57,6 +149,8 @@ public:
 
     void setZoom(double zoom) noexcept;
     double getZoom() const noexcept;
+    // Number type of the rendering at this zoom
+    Snapshot::Precision getPrecision(double zoom) const noexcept;
 
     void setDetailLevel(unsigned detailLevel) noexcept;
     unsigned getDetailLevel() const noexcept;
@@ -64,19 +158,60 @@ public:
     void setAutoAdjustDetail(bool autoAdj) noexcept;
     bool autoAdjustDetail()  const noexcept;
 
+    void setDetailMode(DetailMode mode) noexcept;
+    DetailMode getDetailMode() const noexcept;
+
+    void setDistanceEstimation(bool estimate) noexcept;
+    bool distanceEstimation() const noexcept;
+    const FrameVector<float>& getDistanceEstimate() const noexcept;
+
+    // The frames of another formula can't be resumed nor reused
+    void setFormula(const Formula &formula) noexcept;
+    const Formula& getFormula() const noexcept;
+    // Position in the complex plane of the center of the view
+    sf::Vector2<double> getCenter() const noexcept;
+    // Nucleus of the lowest period around the view, up to the detail level, see locateNucleus.
+    // Stops the rendering and the prefetch. Only for z^2 + c
+    bool findNucleus(Nucleus &nucleus);
+
+    void setPaletteMode(Palette::Mode mode) noexcept;
+    Palette::Mode getPaletteMode() const noexcept;
+    void recolor() noexcept; // Colour the last frame again, without computing it
+
+    bool copySnapshot(Snapshot::Frame &frame) const; // The last complete frame, see Snapshot::save
+    bool loadSnapshot(const std::string &fileName);   // Replace the view and the frame, of the same size
+
     void setNormalizedPosition(sf::Vector2<double> position) noexcept;
     sf::Vector2<double> getNormalizedPosition() const noexcept;
 
     const sf::Texture& getTexture() noexcept;
+    // Blockant until the deadline at most, stops the rendering and computes the current view at a size up
+    // to the one of the image, without the distance estimate. The frame is in getPreviewTexture().
+    // False if the deadline is reached first, then getPreviewTexture() keeps the previous one, or if
+    // a deep screenshot is computing in GMP. time is the time spent, zero in the last case
+    bool renderPreview(const sf::Vector2u size, const sf::Time deadline, sf::Time &time);
+    const sf::Texture& getPreviewTexture() const noexcept;
+    // RGBA of the last complete frame, without the panels of the window. False while rendering
+    bool copyPixels(std::vector<sf::Uint8> &pixels) const;
+    sf::Vector2u getImageSize() const noexcept;
 
     long double getGmpRenderBeginning() const noexcept;
     double getLongDoubleRenderBeginning() const noexcept;
     float getDoubleRenderBeginning() const noexcept;
 
     bool isRenderingFinished() const noexcept;
+    // Block until the rendering is finished or for timeout, returns isRenderingFinished()
+    bool waitRendering(sf::Time timeout);
+
+    // Compute these views in the background, at a low priority, until a rendering is asked.
+    // Not in the histogram detail mode nor with the distance estimate
+    void prefetch(const std::vector<View> &views);
+    // Threads of the prefetch, and memory of the cache of frames, encoded
+    void setPrefetchBudget(unsigned threadCount, std::size_t cacheBytes) noexcept;
 
     void performRendering() noexcept;
     void performRenderingSync() noexcept; // Blockant version
+    // Blockant, until the rendering in progress is stopped
     void abort() noexcept;
 };
 
@@ -0,0 +1,42 @@
+#ifndef RESOLUTIONCONTROLLER_H
+#define RESOLUTIONCONTROLLER_H
+
+// Sfml include
+// - System
+#include <SFML/System/Vector2.hpp>
+#include <SFML/System/Time.hpp>
+
+// Personal include
+#include "Snapshot.h"
+
+// Size of the frames shown while the view is moved, so that each one is computed in about the frame time.
+// The cost of a pixel changes with the zoom, the precision and the detail level, so it is measured
+// on the last frames and the next size follows it
+class ResolutionController
+{
+public:
+    ResolutionController(const sf::Vector2u fullSize, const sf::Time frameTime);
+
+    void setFrameTime(const sf::Time frameTime) noexcept;
+    sf::Time getFrameTime() const noexcept;
+    // A frame computed for longer is dropped
+    sf::Time getDeadline() const noexcept;
+
+    // View of the next frames. The cost measured in another number type is forgotten,
+    // the one of a pixel follows the detail level
+    void setView(const Snapshot::Precision precision, const unsigned detailLevel) noexcept;
+
+    // Size of the next frame, with the proportions of the full one and not larger
+    sf::Vector2u getFrameSize() const noexcept;
+    // Time taken by a frame of this size, or until its deadline if it was dropped
+    void addFrame(const sf::Vector2u size, const sf::Time time) noexcept;
+
+private:
+    sf::Vector2u m_fullSize;
+    sf::Time m_frameTime;
+    Snapshot::Precision m_precision;
+    unsigned m_detailLevel;
+    double m_iterationCost; // Seconds by pixel and by unit of detail level, averaged on the last frames. 0 before the first one
+};
+
+#endif // RESOLUTIONCONTROLLER_H
@@ -0,0 +1,64 @@
+#ifndef SCREENSHOTQUEUE_H
+#define SCREENSHOTQUEUE_H
+
+// Std include
+#include <deque>
+#include <vector>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+
+// Sfml include
+// - System
+#include <SFML/System/Thread.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Config.hpp> // For uint etc ...
+
+// Personal include
+#include "Poster.h"
+#include "Snapshot.h"
+
+// Screenshots written to PNG, and their snapshots, by a thread of their own, one after the other in the order
+// they were taken, so the window never waits for an encoding, a file, nor for the rendering of a larger screenshot
+class ScreenshotQueue
+{
+public:
+    ScreenshotQueue();
+
+    ScreenshotQueue(const ScreenshotQueue& ) = delete;
+
+    // Blockant, until the queued screenshots are written
+    ~ScreenshotQueue();
+
+    // Write these RGBA pixels
+    void push(const std::string &fileName, const sf::Vector2u size, std::vector<sf::Uint8> &&pixels);
+    // Render the view of the poster, then write it
+    void push(const std::string &fileName, std::unique_ptr<Poster> poster);
+    // Save this copy of a frame, see Snapshot::save
+    void push(const std::string &fileName, std::unique_ptr<Snapshot::Frame> snapshot);
+
+    // Screenshots queued or being written
+    std::size_t getPendingCount();
+
+private:
+    struct Job
+    {
+        std::string fileName;
+        sf::Vector2u size;
+        std::vector<sf::Uint8> pixels;
+        std::unique_ptr<Poster> poster; // Null if the pixels are given
+        std::unique_ptr<Snapshot::Frame> snapshot; // Not null for a snapshot, without pixels
+    };
+
+    void run();
+    void write(Job &job);
+
+    std::deque<Job> m_jobs; // The front one is being written
+    bool m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_jobQueued;
+    sf::Thread m_thread;
+};
+
+#endif // SCREENSHOTQUEUE_H
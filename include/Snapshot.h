@@ -0,0 +1,80 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Std include
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Sfml include
+// - System
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Config.hpp> // For uint etc ...
+
+// Personal include
+#include "Formula.h"
+#include "FrameAllocator.h"
+
+// Binary file of a rendered frame : its view, then the raw buffers of the rendering
+// ( iterations, optional distance estimate and last z of the unfinished orbits ).
+// The buffers are written in parallel, and read back from a memory mapping of the file
+class Snapshot
+{
+public:
+    // Number type of the rendering, which gives the format of the orbits
+    enum class Precision : sf::Uint32{
+        Float,
+        Double,
+        Float128,
+        Gmp
+    };
+
+    struct View
+    {
+        Precision precision;
+        sf::Vector2u size;
+        unsigned detailLevel;
+        double zoom;
+        sf::Vector2<double> normalizedPosition;
+        Formula formula;
+    };
+
+    // Copy of the buffers of a rendered frame, to be saved by another thread
+    struct Frame
+    {
+        View view;
+        std::vector<unsigned> iterations;
+        std::vector<float> distance; // Empty if not saved
+        std::vector<char> orbits;    // Empty if not saved
+        std::size_t orbitSize;       // Of one OrbitState
+    };
+
+    Snapshot();
+
+    Snapshot(const Snapshot& ) = delete;
+
+    ~Snapshot();
+
+    static bool save(const std::string &fileName, const Frame &frame);
+
+    // Map the file, whose buffers stay readable until it is closed
+    bool open(const std::string &fileName);
+    void close() noexcept;
+
+    const View& getView() const noexcept;
+    const unsigned* getIterations() const noexcept;
+    const float* getDistance() const noexcept; // Null if not saved
+    const void* getOrbits() const noexcept;    // Null if not saved
+    std::size_t getOrbitSize() const noexcept;
+
+private:
+    void* m_mapping;
+    std::size_t m_mappingSize;
+    View m_view;
+    const unsigned* m_iterations;
+    const float* m_distance;
+    const void* m_orbits;
+    std::size_t m_orbitSize;
+};
+
+#endif // SNAPSHOT_H
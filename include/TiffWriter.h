@@ -0,0 +1,51 @@
+#ifndef TIFFWRITER_H
+#define TIFFWRITER_H
+
+// Std include
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+
+// Sfml include
+// - System
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Config.hpp> // For uint etc ...
+
+// Write an uncompressed RGB TIFF strip by strip, without keeping the image in memory.
+// The place of each strip is known when the file is opened, so the strips can be written in any order.
+// A BigTIFF is written when the image doesn't fit in the 4 GB of a classic TIFF
+class TiffWriter
+{
+public:
+    TiffWriter();
+
+    TiffWriter(const TiffWriter& ) = delete;
+
+    // Create the file and write its header, for an image of 'size' cut in strips of 'rowsPerStrip' rows.
+    // With keepStrips, the file of the same image must exist, and the strips already written are kept
+    bool open(const std::string &fileName, const sf::Vector2u size, const unsigned rowsPerStrip,
+              const bool keepStrips = false);
+
+    // Write the rows of a strip, 3 bytes by pixel. The last strip may have less rows
+    bool writeStrip(const unsigned strip, const std::vector<sf::Uint8> &rgb);
+
+    // Blockant, until the written strips are on the disk, so a manifest saved after can count on them
+    bool flush();
+    bool close();
+
+    unsigned getStripCount() const noexcept;
+    unsigned getStripRows(const unsigned strip) const noexcept;
+
+private:
+    std::uint64_t getStripOffset(const unsigned strip) const noexcept;
+    std::uint64_t getStripSize(const unsigned strip) const noexcept;
+
+    std::ofstream m_file;
+    std::string m_fileName;
+    sf::Vector2u m_size;
+    unsigned m_rowsPerStrip;
+    std::uint64_t m_dataOffset; // Position of the first strip
+};
+
+#endif // TIFFWRITER_H
@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Std include
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Timeline of the rendering, saved in the Chrome trace event format ( chrome://tracing, Perfetto ).
+// Built with -DMANDELBROT_TRACE only : otherwise TRACE_SPAN is empty and nothing is recorded.
+// Each thread writes its spans in its own ring buffer, without lock : only the
+// last Trace::ringCapacity spans of each thread are kept. The buffer of a finished thread
+// is taken by the next new one, so there are as many as threads running at once
+class Trace
+{
+public:
+#ifdef MANDELBROT_TRACE
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    static constexpr std::size_t ringCapacity = 1 << 14; // Power of 2
+
+    // Nanoseconds since the start of the program
+    static std::uint64_t now() noexcept;
+
+    // Span of the calling thread, arg is shown with it if it isn't negative
+    static void record(const char* name, const std::uint64_t begin, const std::int64_t arg) noexcept;
+
+    // Write the spans of all the threads. Returns false if the file couldn't be written,
+    // or if the tracing isn't compiled
+    static bool dump(const std::string &fileName);
+};
+
+// Record the span from its construction to its destruction. The name must be a literal
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name, const std::int64_t arg = -1) noexcept:
+        m_name(name), m_arg(arg), m_begin(Trace::now())
+    {}
+
+    TraceSpan(const TraceSpan& ) = delete;
+
+    ~TraceSpan()
+    {
+        Trace::record(m_name, m_begin, m_arg);
+    }
+
+private:
+    const char* m_name;
+    const std::int64_t m_arg;
+    const std::uint64_t m_begin;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef MANDELBROT_TRACE
+    #define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+    #define TRACE_SPAN_ARG(name, arg) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, static_cast<std::int64_t>(arg))
+#else
+    #define TRACE_SPAN(name) static_cast<void>(0)
+    #define TRACE_SPAN_ARG(name, arg) static_cast<void>(0)
+#endif
+
+#endif // TRACE_H
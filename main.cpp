@@ -7,26 +7,202 @@
 
 // Personal include
 #include "Application.h"
+#include "Poster.h"
+#include "JobManifest.h"
+#include "DistributedRender.h"
+#include "Trace.h"
+#include "LatencyHarness.h"
+#include "FrameAllocator.h"
 
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
 
-int main()
+// Connect to the workers of "host:port,host:port..."
+bool connectWorkers(const std::string &list, RenderCoordinator &coordinator)
+{
+    std::vector<std::string> addresses;
+    std::size_t begin = 0;
+    while(begin <= list.size())
+    {
+        const std::size_t end = std::min(list.find(',', begin), list.size());
+        if(end > begin)
+            addresses.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return coordinator.connect(addresses);
+}
+
+// mandelbrot --worker PORT [THREADS] [ADDRESS] computes the jobs of the coordinators connected to PORT,
+// on the loopback unless the IPv4 ADDRESS of a trusted network is given
+int runWorker(int argc, char* argv[])
+{
+    const unsigned threadCount = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : kernelThreadCount);
+    const std::string address = (argc > 4 ? argv[4] : "127.0.0.1");
+    RenderWorker worker(threadCount);
+    if(!worker.serve(static_cast<unsigned short>(std::strtoul(argv[2], nullptr, 10)), address)){
+        std::cerr << "Can not listen on " << address << ':' << argv[2] << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+// mandelbrot --poster WIDTHxHEIGHT [--zoom Z] [--position X Y] [--detail N] [--power D] [--julia CR CI]
+//            [--output FILE] [--workers LIST] [--trace FILE]
+// renders the view to a TIFF file, without opening a window
+int renderPoster(int argc, char* argv[])
+{
+    RenderCoordinator coordinator;
+    bool distributed = false;
+
+    sf::Vector2u size(0, 0);
+    double zoom = 1.0;
+    sf::Vector2<double> position(0.4, 0.5);
+    unsigned detailLevel = 500;
+    Formula formula;
+    std::string fileName = "poster.tif";
+    std::string traceName;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const int left = argc - i - 1;
+        if(arg == "--poster" && left >= 1)
+            std::sscanf(argv[++i], "%ux%u", &size.x, &size.y);
+        else if(arg == "--zoom" && left >= 1)
+            zoom = std::atof(argv[++i]);
+        else if(arg == "--position" && left >= 2){
+            position.x = std::atof(argv[++i]);
+            position.y = std::atof(argv[++i]);
+        }else if(arg == "--detail" && left >= 1)
+            detailLevel = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--power" && left >= 1)
+            formula.power = std::max(2ul, std::min<unsigned long>(std::strtoul(argv[++i], nullptr, 10), maximumFormulaPower));
+        else if(arg == "--julia" && left >= 2){
+            formula.kind = Formula::Kind::Julia;
+            formula.juliaReal = std::atof(argv[++i]);
+            formula.juliaImag = std::atof(argv[++i]);
+        }
+        else if(arg == "--output" && left >= 1)
+            fileName = argv[++i];
+        else if(arg == "--trace" && left >= 1)
+            traceName = argv[++i];
+        else if(arg == "--workers" && left >= 1){
+            if(!connectWorkers(argv[++i], coordinator))
+                return 1;
+            distributed = true;
+        }else{
+            std::cerr << "Unknown argument \"" << arg << "\"\n";
+            return 1;
+        }
+    }
+
+    if(size.x == 0 || size.y == 0 || detailLevel == 0){
+        std::cerr << "Usage : --poster WIDTHxHEIGHT [--zoom Z] [--position X Y] [--detail N] [--power D] [--julia CR CI]\n"
+                     "                 [--output FILE] [--workers LIST] [--trace FILE]\n";
+        return 1;
+    }
+
+    Poster poster(size, zoom, position, detailLevel, formula);
+    if(distributed)
+        poster.setCoordinator(&coordinator);
+    if(!poster.render(fileName)){
+        std::cerr << "Can not write \"" << fileName << "\"\n";
+        return 1;
+    }
+    if(!traceName.empty() && !Trace::dump(traceName)){
+        std::cerr << "Can not write the trace \"" << traceName << "\" ( built without MANDELBROT_TRACE ? )\n";
+    }
+    return 0;
+}
+
+// mandelbrot --latency [SCRIPT] replays the inputs of the script ( see LatencyHarness ) in the explorer
+// and prints the percentiles of the time they take to be displayed
+int measureLatency(int argc, char* argv[])
 {
     sf::RenderWindow window(sf::VideoMode::getDesktopMode(), "Fractale", sf::Style::Fullscreen);
+    Application app(window);
+
+    LatencyHarness harness(window, app);
+    if(argc > 2){
+        if(!harness.loadScript(argv[2])){
+            std::cerr << "Can not read the script \"" << argv[2] << "\"\n";
+            return 1;
+        }
+    }else{
+        harness.loadDefaultScript();
+    }
+
+    harness.run();
+    harness.printReport(std::cout);
+    return 0;
+}
+
+// mandelbrot [--snapshot FILE] opens the explorer, on a saved view of the size of the screen
+// mandelbrot --resume FILE [--workers LIST] continues the video or the poster of a job manifest
+// The environment variable MANDELBROT_AFFINITY places the rendering threads, see ThreadPlacement,
+// and MANDELBROT_FRAME_TIME gives the milliseconds of a frame while the view is moved
+int main(int argc, char* argv[])
+{
+    const char* affinity = std::getenv("MANDELBROT_AFFINITY");
+    if(affinity && !ThreadPlacement::configure(affinity))
+        std::cerr << "Unknown affinity \"" << affinity << "\", expected none, spread or node:N\n";
+
+    const std::string command = (argc > 1 ? argv[1] : "");
+    const bool openSnapshot = (argc == 3 && command == "--snapshot");
+    const bool resumeJob = ((argc == 3 || (argc == 5 && std::string(argv[3]) == "--workers")) && command == "--resume");
+    if(argc > 2 && command == "--worker")
+        return runWorker(argc, argv);
+    if(argc <= 3 && command == "--latency")
+        return measureLatency(argc, argv);
+    if(argc > 1 && !openSnapshot && !resumeJob)
+        return renderPoster(argc, argv);
+
+    if(resumeJob)
+    {
+        JobManifest manifest;
+        if(!manifest.load(argv[2])){
+            std::cerr << "Can not open \"" << argv[2] << "\"\n";
+            return 1;
+        }
+        if(manifest.get("job") == "poster")
+        {
+            RenderCoordinator coordinator;
+            if(argc == 5 && !connectWorkers(argv[4], coordinator))
+                return 1;
+            return (Poster::resume(argv[2], (argc == 5 ? &coordinator : nullptr)) ? 0 : 1);
+        }
+    }
+
+    sf::RenderWindow window(sf::VideoMode::getDesktopMode(), "Fractale", sf::Style::Fullscreen);
    // sf::RenderWindow window(sf::VideoMode(160*2, 90*2), "Fractale");
 
     Application app(window);
+    const char* frameTime = std::getenv("MANDELBROT_FRAME_TIME");
+    if(frameTime && std::atoi(frameTime) > 0)
+        app.setPreviewFrameTime(sf::milliseconds(std::atoi(frameTime)));
+    if(openSnapshot && !app.loadSnapshot(argv[2])){
+        std::cerr << "Can not open \"" << argv[2] << "\"\n";
+    }
+    if(resumeJob && !app.resumeVideo(argv[2])){
+        std::cerr << "Can not resume \"" << argv[2] << "\"\n";
+    }
 
     sf::Clock clock;
 
     while (window.isOpen())
     {
-        app.handleEvent();
+        app.handleEvent(); // Blocks while nothing happens
         app.update();
 
-        window.clear();
-        app.draw();
-        window.display();
+        if(app.needRedraw()){
+            window.clear();
+            app.draw();
+            window.display();
+        }
 
        // std::cout << 1.0 / clock.restart().asSeconds()<< '\n';
     }
@@ -4,34 +4,54 @@
 #include <sstream>
 #include <stdexcept>
 #include <cstdlib> // to save screen
+#include <cstdio> // std::remove
 #include <ctime> // to save screen
 #include <map>
 #include <cmath>
 #include <string>
 #include <iostream>
+#include <memory>
+#include <algorithm>
 
 // Sfml include
 // - Graphics
 #include <SFML/Graphics/Text.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
 
-// System
-#include <SFML/System/Sleep.hpp>
+// Personal include
+#include "Poster.h"
+#include "JobManifest.h"
+#include "Trace.h"
 
 Application::Application(sf::RenderWindow& window):
     m_window(window),
     m_fractaleSprite(),
     m_fractaleRenderer(window.getSize()),
+    m_mandelbrotView{1, sf::Vector2<double>(0.4, 0.5)},
     m_font(),
     m_showText(true),
     m_sound(),
     m_photoBuffer(),
+    m_screenshots(),
+    m_pendingScreen(),
     m_isMousePressed(false),
     m_mouseSelection(),
     m_clock(),
     m_lastTime(),
     m_actionHappened(false),
-    m_changeTexture(true)
+    m_changeTexture(true),
+    m_needRedraw(true),
+    m_wasRenderingFinished(false),
+    m_viewShown(false),
+    m_simulatedKeys(),
+    m_resolution(window.getSize(), sf::milliseconds(previewFrameTime)),
+    m_previewOutdated(false),
+    m_infoText(),
+    m_zoomInfoText(),
+    m_infoBackground(),
+    m_zoomInfoBackground(),
+    m_infoString(),
+    m_zoomInfoString()
 {
     if(!m_font.loadFromFile("arial.ttf")){
         m_showText = false;
@@ -41,38 +61,62 @@ Application::Application(sf::RenderWindow& window):
     }
     m_sound.setBuffer(m_photoBuffer);
 
+    for(sf::Text* text : {&m_infoText, &m_zoomInfoText}){
+        text->setFont(m_font);
+        text->setCharacterSize(18);
+        text->setColor(sf::Color::Blue);
+    }
+    m_infoText.setPosition(5, 5);
+    m_infoBackground.setFillColor(sf::Color(50, 50, 50, 150));
+    m_zoomInfoBackground.setFillColor(sf::Color(50, 50, 50, 150));
+
+    m_fractaleRenderer.setPrefetchBudget(prefetchThreadCount, prefetchCacheMegabytes << 20);
     m_fractaleRenderer.performRendering();
 }
 
+bool Application::loadSnapshot(const std::string &fileName)
+{
+    if(!m_fractaleRenderer.loadSnapshot(fileName))
+        return false;
+    m_changeTexture = true;
+    return true;
+}
+
 void Application::handleEvent()
 {
     sf::Event event;
-    while(m_window.pollEvent(event))
-    {
-        switch(event.type)
-        {
-        case sf::Event::Closed:
-            m_window.close();
-            break;
-        case sf::Event::MouseMoved:
-        case sf::Event::MouseButtonPressed:
-        case sf::Event::MouseButtonReleased:
-            handleMouseEvent(event);
-            break;
-        case sf::Event::KeyPressed:
-            handleKeyPressedEvent(event);
-            break;
-        default:
-            break;
-        }
+    if(isIdle()){
+        // Nothing can change before an input
+        if(m_window.waitEvent(event))
+            handleOneEvent(event);
+    }else if(!m_fractaleRenderer.isRenderingFinished()){
+        // Until the end of the rendering, the inputs are still read every inputLatency
+        m_fractaleRenderer.waitRendering(sf::milliseconds(inputLatency));
     }
+
+    while(m_window.pollEvent(event))
+        handleOneEvent(event);
 }
 
 void Application::update()
 {
+    if(!m_pendingScreen.empty() && m_fractaleRenderer.isRenderingFinished()){
+        writeScreen(m_pendingScreen);
+        m_pendingScreen.clear();
+    }
+
+    // The full resolution is only computed once the keys are released
+    if(m_actionHappened && m_previewOutdated && !doAction()){
+        showPreview();
+    }
+
     if(m_fractaleRenderer.isRenderingFinished() && m_changeTexture){
-        m_fractaleSprite.setTexture(m_fractaleRenderer.getTexture());
+        m_fractaleSprite.setTexture(m_fractaleRenderer.getTexture(), true);
+        m_fractaleSprite.setScale(1, 1);
         m_changeTexture = false;
+        m_needRedraw = true;
+        m_viewShown = !m_actionHappened; // Else the view changed since this rendering started
+        prefetchNeighbours();
     }
 
 
@@ -81,10 +125,58 @@ void Application::update()
         m_actionHappened = false;
         m_changeTexture = true;
     }
+
+    if(m_wasRenderingFinished != m_fractaleRenderer.isRenderingFinished()){
+        m_wasRenderingFinished = !m_wasRenderingFinished;
+        m_needRedraw = true;
+    }
+
+    if(m_needRedraw){
+        updateInfo();
+    }
+}
+
+bool Application::needRedraw() const noexcept
+{
+    return m_needRedraw;
+}
+
+void Application::simulateEvent(sf::Event event)
+{
+    handleOneEvent(event);
+}
+
+void Application::simulateKey(sf::Keyboard::Key key, bool held)
+{
+    const auto found = std::find(m_simulatedKeys.begin(), m_simulatedKeys.end(), key);
+    if(held && found == m_simulatedKeys.end())
+        m_simulatedKeys.push_back(key);
+    else if(!held && found != m_simulatedKeys.end())
+        m_simulatedKeys.erase(found);
+}
+
+bool Application::isIdle() const
+{
+    // A pending action waits for the release of the keys, which is an event,
+    // a preview which missed its deadline is tried again without one
+    return m_fractaleRenderer.isRenderingFinished() && !m_changeTexture && !m_needRedraw
+           && !(m_actionHappened && (doAction() || m_previewOutdated));
+}
+
+bool Application::isViewShown() const noexcept
+{
+    return m_viewShown;
+}
+
+void Application::setPreviewFrameTime(sf::Time frameTime) noexcept
+{
+    m_resolution.setFrameTime(frameTime);
 }
 
 void Application::draw()
 {
+    m_needRedraw = false;
+
     m_window.draw(m_fractaleSprite);
     if(m_isMousePressed)
     {
@@ -99,6 +191,55 @@ void Application::draw()
 }
 
 // PRIVATE
+void Application::handleOneEvent(sf::Event event)
+{
+    // Moving the mouse without selecting doesn't change the window
+    if(event.type != sf::Event::MouseMoved || m_isMousePressed){
+        m_needRedraw = true;
+    }
+
+    switch(event.type)
+    {
+    case sf::Event::Closed:
+        m_window.close();
+        break;
+    case sf::Event::MouseMoved:
+    case sf::Event::MouseButtonPressed:
+    case sf::Event::MouseButtonReleased:
+        handleMouseEvent(event);
+        break;
+    case sf::Event::KeyPressed:
+        handleKeyPressedEvent(event);
+        break;
+    default:
+        break;
+    }
+}
+
+void Application::showPreview()
+{
+    m_resolution.setView(m_fractaleRenderer.getPrecision(m_fractaleRenderer.getZoom()), m_fractaleRenderer.getDetailLevel());
+
+    // Tried again at the next update, smaller if the deadline was reached
+    const sf::Vector2u size = m_resolution.getFrameSize();
+    sf::Time time;
+    const bool shown = m_fractaleRenderer.renderPreview(size, m_resolution.getDeadline(), time);
+    if(time != sf::Time::Zero)
+        m_resolution.addFrame(size, time);
+    if(!shown)
+        return;
+
+    const sf::Vector2u windowSize = m_window.getSize();
+    m_fractaleSprite.setTexture(m_fractaleRenderer.getPreviewTexture());
+    m_fractaleSprite.setTextureRect(sf::IntRect(0, 0, size.x, size.y));
+    m_fractaleSprite.setScale(static_cast<float>(windowSize.x) / size.x, static_cast<float>(windowSize.y) / size.y);
+
+    m_changeTexture = false; // The rendering was stopped, a new one starts at the release of the keys
+    m_previewOutdated = false;
+    m_needRedraw = true;
+    m_viewShown = true;
+}
+
 void Application::handleMouseEvent(sf::Event event)
 {
     switch(event.type)
@@ -152,8 +293,28 @@ void Application::handleKeyPressedEvent(sf::Event event)
         // Auto adjust resolution
     case sf::Keyboard::D:
         toggleAutoAdjust();
+        // Only the histogram mode needs a new rendering to choose the details
+        m_actionHappened = (m_fractaleRenderer.getDetailMode() == Render::DetailMode::Histogram);
+        break;
+        // Distance estimation
+    case sf::Keyboard::F:
+        toggleDistanceEstimation();
+        break;
+        // Colours
+    case sf::Keyboard::C:
+        togglePalette();
         m_actionHappened = false; // No need to recalculate
         break;
+        // Formula
+    case sf::Keyboard::J:
+        toggleJulia();
+        break;
+    case sf::Keyboard::M:
+        cyclePower();
+        break;
+    case sf::Keyboard::N:
+        goToNucleus();
+        break;
         // Zoom
     case sf::Keyboard::Z:
         zoom();
@@ -163,7 +324,7 @@ void Application::handleKeyPressedEvent(sf::Event event)
         break;
         // Screen
     case sf::Keyboard::E:
-        takeScreen();
+        takeScreen(event.key.shift);
         m_actionHappened = false; // No need to recalculate
         break;
         // Panel
@@ -180,6 +341,14 @@ void Application::handleKeyPressedEvent(sf::Event event)
         video();
         m_actionHappened = false; // No need to recalculate
         break;
+    case sf::Keyboard::P:
+        poster();
+        m_actionHappened = false; // No need to recalculate
+        break;
+    case sf::Keyboard::T:
+        dumpTrace();
+        m_actionHappened = false; // No need to recalculate
+        break;
     // Quit
     case sf::Keyboard::Escape:
         m_window.close();
@@ -189,10 +358,19 @@ void Application::handleKeyPressedEvent(sf::Event event)
         m_actionHappened = false;
         break;
     }
+    if(m_actionHappened){
+        m_previewOutdated = true;
+        m_viewShown = false;
+    }
 }
 
 // KEY EVENT
 void Application::move(Direction dir)
+{
+    m_fractaleRenderer.setNormalizedPosition(getMovedPosition(dir));
+}
+
+sf::Vector2<double> Application::getMovedPosition(Direction dir) const
 {
     sf::Vector2<double> position = m_fractaleRenderer.getNormalizedPosition();
     double renderZoom = m_fractaleRenderer.getZoom();
@@ -205,14 +383,28 @@ void Application::move(Direction dir)
         case Direction::Down  : position.y += offset; break;
         default: break;
     }
+    return position;
+}
 
-    m_fractaleRenderer.setNormalizedPosition(position);
+void Application::prefetchNeighbours()
+{
+    // The views of the navigation keys, the same values as the ones they will set
+    const double renderZoom = m_fractaleRenderer.getZoom();
+    const sf::Vector2<double> position = m_fractaleRenderer.getNormalizedPosition();
+    m_fractaleRenderer.prefetch({
+        {renderZoom * zoomFactor, position},
+        {renderZoom, getMovedPosition(Direction::Left)},
+        {renderZoom, getMovedPosition(Direction::Right)},
+        {renderZoom, getMovedPosition(Direction::Up)},
+        {renderZoom, getMovedPosition(Direction::Down)},
+        {renderZoom / zoomFactor, position}
+    });
 }
 
 void Application::increaseDetail()
 {
     unsigned step = 1;
-    if(sf::Keyboard::isKeyPressed(sf::Keyboard::RControl) || sf::Keyboard::isKeyPressed(sf::Keyboard::LControl)){
+    if(isKeyHeld(sf::Keyboard::RControl) || isKeyHeld(sf::Keyboard::LControl)){
         step = 10;
     }
     m_fractaleRenderer.setDetailLevel(m_fractaleRenderer.getDetailLevel() + step);
@@ -221,7 +413,7 @@ void Application::increaseDetail()
 void Application::decreaseDetail()
 {
     unsigned step = 1;
-    if(sf::Keyboard::isKeyPressed(sf::Keyboard::RControl) || sf::Keyboard::isKeyPressed(sf::Keyboard::LControl)){
+    if(isKeyHeld(sf::Keyboard::RControl) || isKeyHeld(sf::Keyboard::LControl)){
         step = 10;
     }
     auto detail  = m_fractaleRenderer.getDetailLevel() - step;
@@ -234,25 +426,53 @@ void Application::decreaseDetail()
 void Application::zoom()
 {
     double renderZoom = m_fractaleRenderer.getZoom();
-    m_fractaleRenderer.setZoom(renderZoom * 1.3);
+    m_fractaleRenderer.setZoom(renderZoom * zoomFactor);
 }
 
 void Application::unzoom()
 {
     double renderZoom = m_fractaleRenderer.getZoom();
-    m_fractaleRenderer.setZoom(renderZoom / 1.3);
+    m_fractaleRenderer.setZoom(renderZoom / zoomFactor);
 }
 
-void Application::takeScreen()
+void Application::takeScreen(bool highResolution)
 {
     m_sound.play();
-    sf::Image screen = m_window.capture();
     std::ostringstream fileName;
-    fileName << "screen-" << time(nullptr) << "-" << rand() % 1000 << ".png";
-    screen.saveToFile(fileName.str());
+    fileName << "screen-" << time(nullptr) << "-" << rand() % 1000;
+
+    if(highResolution){
+        // Computed by bands beside the renderer, with the linear palette of the posters.
+        // In GMP, the bands and the renderings of the window take turns, see gmpPrecisionMutex
+        std::unique_ptr<Poster> poster(new Poster(m_fractaleRenderer.getImageSize() * screenshotScale,
+                                                  m_fractaleRenderer.getZoom(), m_fractaleRenderer.getNormalizedPosition(),
+                                                  m_fractaleRenderer.getDetailLevel(), m_fractaleRenderer.getFormula()));
+        m_screenshots.push(fileName.str() + ".png", std::move(poster));
+    }else if(m_fractaleRenderer.isRenderingFinished()){
+        writeScreen(fileName.str());
+    }else{
+        m_pendingScreen = fileName.str();
+    }
+}
+
+void Application::writeScreen(const std::string &fileName)
+{
+    std::vector<sf::Uint8> pixels;
+    {
+        TRACE_SPAN("capture");
+        if(!m_fractaleRenderer.copyPixels(pixels))
+            return;
+    }
+    m_screenshots.push(fileName + ".png", m_fractaleRenderer.getImageSize(), std::move(pixels));
 
-    while (m_sound.getStatus() == sf::Sound::Playing)
-            sf::sleep(sf::milliseconds(10));
+    // To colour it again or raise its details later. Copied here, written by the thread of the screenshots
+    std::unique_ptr<Snapshot::Frame> snapshot(new Snapshot::Frame());
+    {
+        TRACE_SPAN("capture");
+        if(!m_fractaleRenderer.copySnapshot(*snapshot))
+            return;
+    }
+    m_screenshots.push(fileName + ".snap", std::move(snapshot));
 }
 
 void Application::togglePanel()
@@ -262,7 +482,74 @@ void Application::togglePanel()
 
 void Application::toggleAutoAdjust()
 {
-    m_fractaleRenderer.setAutoAdjustDetail(!m_fractaleRenderer.autoAdjustDetail());
+    // Zoom -> Histogram -> Manual -> Zoom
+    switch(m_fractaleRenderer.getDetailMode())
+    {
+        case Render::DetailMode::Zoom      : m_fractaleRenderer.setDetailMode(Render::DetailMode::Histogram); break;
+        case Render::DetailMode::Histogram : m_fractaleRenderer.setDetailMode(Render::DetailMode::Manual); break;
+        case Render::DetailMode::Manual    : m_fractaleRenderer.setDetailMode(Render::DetailMode::Zoom); break;
+        default: break;
+    }
+}
+
+void Application::toggleDistanceEstimation()
+{
+    m_fractaleRenderer.setDistanceEstimation(!m_fractaleRenderer.distanceEstimation());
+}
+
+void Application::togglePalette()
+{
+    if(m_fractaleRenderer.getPaletteMode() == Palette::Mode::Linear){
+        m_fractaleRenderer.setPaletteMode(Palette::Mode::HistogramEqualized);
+    }else{
+        m_fractaleRenderer.setPaletteMode(Palette::Mode::Linear);
+    }
+    m_fractaleRenderer.recolor();
+    m_changeTexture = true;
+}
+
+void Application::toggleJulia()
+{
+    Formula formula = m_fractaleRenderer.getFormula();
+    if(formula.kind == Formula::Kind::Mandelbrot){
+        // The Julia set of the point at the center of the view, seen whole around 0
+        const sf::Vector2<double> center = m_fractaleRenderer.getCenter();
+        m_mandelbrotView = Render::View{m_fractaleRenderer.getZoom(), m_fractaleRenderer.getNormalizedPosition()};
+        formula = Formula(Formula::Kind::Julia, formula.power, center.x, center.y);
+        m_fractaleRenderer.setZoom(1);
+        m_fractaleRenderer.setNormalizedPosition(ViewGeometry<double>::normalizedPositionOf(m_window.getSize(), 0, 0));
+    }else{
+        formula.kind = Formula::Kind::Mandelbrot;
+        m_fractaleRenderer.setZoom(m_mandelbrotView.scale);
+        m_fractaleRenderer.setNormalizedPosition(m_mandelbrotView.normalizedPosition);
+    }
+    m_fractaleRenderer.setFormula(formula);
+}
+
+void Application::cyclePower()
+{
+    // 2 -> 3 -> ... -> maximumFormulaPower -> 2
+    Formula formula = m_fractaleRenderer.getFormula();
+    formula.power = (formula.power - 1) % (maximumFormulaPower - 1) + 2;
+    m_fractaleRenderer.setFormula(formula);
+}
+
+void Application::goToNucleus()
+{
+    Nucleus nucleus;
+    if(!m_fractaleRenderer.findNucleus(nucleus)){
+        std::cerr << "No minibrot found in the view, or too deep to be shown\n";
+        return; // The stopped rendering is resumed
+    }
+
+    // Straight to the minibrot, without the views between
+    double zoom = 1;
+    sf::Vector2<double> position;
+    nucleusView(nucleus, m_window.getSize(), zoom, position);
+    m_fractaleRenderer.setZoom(zoom);
+    m_fractaleRenderer.setNormalizedPosition(position);
+    if(m_fractaleRenderer.getDetailLevel() < nucleus.period * minibrotDetailPerPeriod)
+        m_fractaleRenderer.setDetailLevel(nucleus.period * minibrotDetailPerPeriod);
 }
 
 void Application::refresh()
@@ -274,24 +561,113 @@ void Application::refresh()
 void Application::video()
 {
     m_window.close();
-    auto date = time(nullptr);
-    auto fractZoom = m_fractaleRenderer.getZoom();
+    m_fractaleRenderer.abort();
+
+    JobManifest manifest;
+    manifest.set("job", "video");
+    manifest.setNumber("date", time(nullptr));
+    manifest.setNumber("zoom", m_fractaleRenderer.getZoom());
+    manifest.setNumber("positionX", m_fractaleRenderer.getNormalizedPosition().x);
+    manifest.setNumber("positionY", m_fractaleRenderer.getNormalizedPosition().y);
+    manifest.setNumber("detailMode", static_cast<int>(m_fractaleRenderer.getDetailMode()));
+    manifest.setNumber("detailLevel", m_fractaleRenderer.getDetailLevel());
+    manifest.setFormula(m_fractaleRenderer.getFormula());
+    manifest.setNumber("nextFrame", 0);
+    renderVideo(manifest);
+}
+
+bool Application::resumeVideo(const std::string &manifestName)
+{
+    JobManifest manifest;
+    if(!manifest.load(manifestName) || manifest.get("job") != "video")
+        return false;
+
+    m_window.close();
+    m_fractaleRenderer.abort();
+
+    m_fractaleRenderer.setNormalizedPosition(sf::Vector2<double>(manifest.getNumber("positionX"),
+                                                                 manifest.getNumber("positionY")));
+    m_fractaleRenderer.setDetailMode(static_cast<Render::DetailMode>(manifest.getNumber("detailMode")));
+    m_fractaleRenderer.setDetailLevel(manifest.getNumber("detailLevel"));
+    m_fractaleRenderer.setFormula(manifest.getFormula());
+    renderVideo(manifest);
+    return true;
+}
+
+void Application::renderVideo(JobManifest &manifest)
+{
+    const auto date = static_cast<time_t>(manifest.getNumber("date"));
+    auto fractZoom = manifest.getNumber("zoom");
+    const unsigned firstFrame = manifest.getNumber("nextFrame");
     const auto factor = 1.05;
     const auto maxImg = floor(exp(log(fractZoom) / factor)); // log = logarithm neperien
 
+    std::ostringstream manifestName;
+    manifestName << "video/video-" << date << ".job";
+
     unsigned j {0};
     for(decltype(fractZoom) i { 1 }; i < fractZoom; i *= factor)
     {
-        m_fractaleRenderer.setZoom(i);
-        m_fractaleRenderer.performRenderingSync();
-        std::cout << j << " / " << maxImg << '\n';
-
-        sf::Image screen = m_fractaleRenderer.getTexture().copyToImage();
-        std::ostringstream fileName;
-        fileName << "video/video-" << date << "-" << j << ".png";
-        screen.saveToFile(fileName.str());
+        // The frames before firstFrame are already saved
+        if(j >= firstFrame)
+        {
+            m_fractaleRenderer.setZoom(i);
+            m_fractaleRenderer.performRenderingSync();
+            std::cout << j << " / " << maxImg << '\n';
+
+            sf::Image screen;
+            {
+                TRACE_SPAN("texture download");
+                screen = m_fractaleRenderer.getTexture().copyToImage();
+            }
+            std::ostringstream fileName;
+            fileName << "video/video-" << date << "-" << j << ".png";
+            {
+                TRACE_SPAN_ARG("png encoding", j);
+                screen.saveToFile(fileName.str());
+            }
+
+            JobManifest::syncFile(fileName.str());
+            manifest.setNumber("nextFrame", j + 1);
+            manifest.save(manifestName.str());
+        }
         ++j;
     }
+
+    std::remove(manifestName.str().c_str());
+}
+
+void Application::poster()
+{
+    // Sides of the poster in window sizes
+    constexpr unsigned posterScale = 8;
+
+    const sf::Vector2u size = m_window.getSize() * posterScale;
+    m_window.close();
+    m_fractaleRenderer.abort();
+
+    std::ostringstream fileName;
+    fileName << "poster-" << time(nullptr) << ".tif";
+    Poster poster(size, m_fractaleRenderer.getZoom(), m_fractaleRenderer.getNormalizedPosition(),
+                  m_fractaleRenderer.getDetailLevel(), m_fractaleRenderer.getFormula());
+    if(!poster.render(fileName.str())){
+        std::cerr << "Can not write \"" << fileName.str() << "\"\n";
+    }
+}
+
+void Application::dumpTrace()
+{
+    std::ostringstream fileName;
+    fileName << "trace-" << time(nullptr) << ".json";
+    if(Trace::dump(fileName.str())){
+        std::cout << "Trace saved in \"" << fileName.str() << "\"\n";
+    }
+}
+
+bool Application::isKeyHeld(sf::Keyboard::Key key) const
+{
+    return sf::Keyboard::isKeyPressed(key)
+           || std::find(m_simulatedKeys.begin(), m_simulatedKeys.end(), key) != m_simulatedKeys.end();
 }
 
 bool Application::isControlKeyPressed() const
@@ -302,7 +678,7 @@ bool Application::isControlKeyPressed() const
         sf::Keyboard::LControl, sf::Keyboard::Z, sf::Keyboard::S};
 
     for(int i {0}; i < 9; ++i){
-        if(sf::Keyboard::isKeyPressed(controlKey[i]))
+        if(isKeyHeld(controlKey[i]))
             return true;
     }
     return false;
@@ -318,18 +694,31 @@ void Application::drawInfo() noexcept
     if(!m_showText)
         return;
 
-    sf::Text infoText;
-    infoText.setFont(m_font);
-    infoText.setCharacterSize(18);
-    infoText.setColor(sf::Color::Blue);
-    infoText.setPosition(5, 5);
+    m_window.draw(m_infoBackground);
+    m_window.draw(m_infoText);
+    m_window.draw(m_zoomInfoBackground);
+    m_window.draw(m_zoomInfoText);
+}
+
+void Application::updateInfo() noexcept
+{
+    if(!m_showText)
+        return;
 
     // Info
     std::ostringstream oss;
     oss << "Z / S : Zoom ; A / Q Details; D Ajustement auto\n"
-           "E : Prendre une photo\n"
+           "F : Estimation de distance\n"
+           "C : Couleurs galises\n"
+           "J : Julia du centre ; M : Puissance de z\n"
+           "N : Aller au minibrot de la vue\n"
+           "E : Prendre une photo ; Maj + E : en grand\n"
+           "P : Poster ( ferme la fentre )\n"
            "H : Texte visible\n"
            "R : Rafraichir ( si a bug )";
+    if(Trace::enabled){
+        oss << "\nT : Enregistrer la trace";
+    }
 
     if(m_fractaleRenderer.getZoom() > m_fractaleRenderer.getGmpRenderBeginning()){
         oss<<"\nUsing GMP";
@@ -348,13 +737,12 @@ void Application::drawInfo() noexcept
         oss << "\nRendering ...";
     }
 
-    infoText.setString(oss.str());
-
-    sf::RectangleShape background(sf::Vector2f(infoText.getGlobalBounds().width+10, infoText.getGlobalBounds().height+15));
-    background.setFillColor(sf::Color(50, 50, 50, 150));
-
-    m_window.draw(background);
-    m_window.draw(infoText);
+    // Laying out a sf::Text is costly, it is only done when its string changes
+    if(oss.str() != m_infoString){
+        m_infoString = oss.str();
+        m_infoText.setString(m_infoString);
+        m_infoBackground.setSize(sf::Vector2f(m_infoText.getGlobalBounds().width+10, m_infoText.getGlobalBounds().height+15));
+    }
 
     // Zoom info
     oss.str("");
@@ -362,25 +750,30 @@ void Application::drawInfo() noexcept
     const std::string zoomText = getZoomText(m_fractaleRenderer.getZoom());
     oss << "\nZoom : " << m_fractaleRenderer.getZoom() <<
            "\nDtails : " << m_fractaleRenderer.getDetailLevel();
-    if(m_fractaleRenderer.autoAdjustDetail()){
+    if(m_fractaleRenderer.getDetailMode() == Render::DetailMode::Histogram){
+        oss << " Auto (histogramme)";
+    }else if(m_fractaleRenderer.autoAdjustDetail()){
         oss << " Auto";
     }
     oss << "\nPosition : " << m_fractaleRenderer.getNormalizedPosition().x << "; " << m_fractaleRenderer.getNormalizedPosition().y;
+    const Formula& formula = m_fractaleRenderer.getFormula();
+    oss << "\nFormule : z^" << formula.power << " + c";
+    if(formula.kind == Formula::Kind::Julia){
+        oss << ", Julia c = " << formula.juliaReal << " + " << formula.juliaImag << "i";
+    }
     if(!zoomText.empty()){
         oss << "\nVous regardez " << zoomText;
     }
-    infoText.setString(oss.str());
-    infoText.setPosition(m_window.getSize().x - infoText.getGlobalBounds().width,
-                         m_window.getSize().y - infoText.getGlobalBounds().height-30);
-    sf::RectangleShape backgroundZoomInfo(sf::Vector2f(infoText.getGlobalBounds().width+2, infoText.getGlobalBounds().height+10));
-    backgroundZoomInfo.setPosition(m_window.getSize().x - infoText.getGlobalBounds().width - 2,
-                                   m_window.getSize().y - infoText.getGlobalBounds().height - 12);
-    backgroundZoomInfo.setFillColor(sf::Color(50, 50, 50, 150));
-
-    m_window.draw(backgroundZoomInfo);
-    m_window.draw(infoText);
-
 
+    if(oss.str() != m_zoomInfoString){
+        m_zoomInfoString = oss.str();
+        m_zoomInfoText.setString(m_zoomInfoString);
+        m_zoomInfoText.setPosition(m_window.getSize().x - m_zoomInfoText.getGlobalBounds().width,
+                                   m_window.getSize().y - m_zoomInfoText.getGlobalBounds().height-30);
+        m_zoomInfoBackground.setSize(sf::Vector2f(m_zoomInfoText.getGlobalBounds().width+2, m_zoomInfoText.getGlobalBounds().height+10));
+        m_zoomInfoBackground.setPosition(m_window.getSize().x - m_zoomInfoText.getGlobalBounds().width - 2,
+                                         m_window.getSize().y - m_zoomInfoText.getGlobalBounds().height - 12);
+    }
 }
 
 std::string Application::getZoomText(double zoom) const noexcept
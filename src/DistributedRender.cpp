@@ -0,0 +1,357 @@
+#include "DistributedRender.h"
+
+// Std include
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Posix include
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// Personal include
+#include "MandelbrotRenderer.h"
+#include "Trace.h"
+
+namespace
+{
+    constexpr sf::Uint32 jobMagic = 0x4A424D47; // "GMBJ", changed with the layout of RenderJob
+
+    // Jobs by worker for each render, so the fast workers take more of them
+    constexpr unsigned jobsPerWorker = 8;
+
+    // Precedes the iterations of the region in the answer of a worker
+    struct AnswerHeader
+    {
+        sf::Uint32 id;
+        sf::Uint32 pixelCount;
+    };
+
+    bool sendAll(const int socket, const void* data, std::size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        while(size > 0)
+        {
+            const ssize_t sent = send(socket, bytes, size, MSG_NOSIGNAL);
+            if(sent <= 0)
+                return false;
+            bytes += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    bool receiveAll(const int socket, void* data, std::size_t size)
+    {
+        char* bytes = static_cast<char*>(data);
+        while(size > 0)
+        {
+            const ssize_t received = recv(socket, bytes, size, 0);
+            if(received <= 0)
+                return false;
+            bytes += received;
+            size -= received;
+        }
+        return true;
+    }
+
+    // Socket connected to "host:port", -1 if it can't be reached
+    int connectTo(const std::string &address)
+    {
+        const std::size_t colon = address.rfind(':');
+        if(colon == std::string::npos)
+            return -1;
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addresses = nullptr;
+        if(getaddrinfo(address.substr(0, colon).c_str(), address.substr(colon + 1).c_str(), &hints, &addresses) != 0)
+            return -1;
+
+        int connection = -1;
+        for(addrinfo* candidate = addresses; candidate && connection < 0; candidate = candidate->ai_next)
+        {
+            connection = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+            if(connection >= 0 && ::connect(connection, candidate->ai_addr, candidate->ai_addrlen) != 0){
+                ::close(connection);
+                connection = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+
+        if(connection >= 0){
+            // The jobs are small, they mustn't wait for more data
+            const int one = 1;
+            setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        return connection;
+    }
+}
+
+// RenderWorker
+RenderWorker::RenderWorker(const unsigned threadCount):
+    m_iterations(),
+    m_threadCount(std::max(1u, threadCount)),
+    m_isRunning(true),
+    m_mutex()
+{}
+
+bool RenderWorker::serve(const unsigned short port, const std::string &bindAddress)
+{
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if(inet_pton(AF_INET, bindAddress.c_str(), &address.sin_addr) != 1)
+        return false;
+
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if(listener < 0)
+        return false;
+
+    const int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 4) != 0){
+        ::close(listener);
+        return false;
+    }
+
+    std::cout << "Worker listening on " << bindAddress << ':' << port << '\n';
+    while(true)
+    {
+        const int connection = accept(listener, nullptr, nullptr);
+        if(connection < 0)
+            continue;
+
+        const int noDelay = 1;
+        setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        handleConnection(connection);
+        ::close(connection);
+    }
+}
+
+// PRIVATE
+bool RenderWorker::handleConnection(const int connection)
+{
+    RenderJob job;
+    while(receiveAll(connection, &job, sizeof(job)))
+    {
+        if(!isValid(job)){
+            std::cerr << "Invalid job, connection closed\n";
+            return false;
+        }
+
+        TRACE_SPAN_ARG("job", job.id);
+
+        m_iterations.resize(static_cast<std::size_t>(job.regionWidth) * job.regionHeight);
+        switch(static_cast<Snapshot::Precision>(job.precision))
+        {
+            case Snapshot::Precision::Float    : renderWith<float>(job); break;
+            case Snapshot::Precision::Double   : renderWith<double>(job); break;
+            case Snapshot::Precision::Float128 : renderWith<__float128>(job); break;
+            default                            : renderWith<mpf_class>(job); break;
+        }
+
+        const AnswerHeader header { job.id, static_cast<sf::Uint32>(m_iterations.size()) };
+        if(!sendAll(connection, &header, sizeof(header))
+           || !sendAll(connection, m_iterations.data(), m_iterations.size() * sizeof(unsigned)))
+            return false;
+    }
+    return true;
+}
+
+bool RenderWorker::isValid(const RenderJob &job)
+{
+    const std::size_t pixelCount = static_cast<std::size_t>(job.regionWidth) * job.regionHeight;
+    return job.magic == jobMagic
+           && job.precision <= static_cast<sf::Uint32>(Snapshot::Precision::Gmp)
+           && job.formulaKind <= static_cast<sf::Uint32>(Formula::Kind::Julia)
+           && job.formulaPower >= 2 && job.formulaPower <= maximumFormulaPower
+           && job.detailLevel > 0
+           && pixelCount > 0 && pixelCount <= maximumJobPixels // So the count of the answer fits its 32 bits
+           && job.originX <= job.imageWidth && job.regionWidth <= job.imageWidth - job.originX
+           && job.originY <= job.imageHeight && job.regionHeight <= job.imageHeight - job.originY
+           && std::isfinite(job.zoom) && job.zoom > 0
+           && std::isfinite(job.positionX) && std::isfinite(job.positionY)
+           && std::isfinite(job.juliaReal) && std::isfinite(job.juliaImag);
+}
+
+template <typename T>
+void RenderWorker::renderWith(const RenderJob &job)
+{
+    IterationOutput<T> output { m_iterations };
+    mandelbrotKernel<T>(output, sf::Vector2u(job.imageWidth, job.imageHeight), sf::Vector2u(job.originX, job.originY),
+                        sf::Vector2u(job.regionWidth, job.regionHeight), job.zoom, job.detailLevel, 0,
+                        sf::Vector2<double>(job.positionX, job.positionY),
+                        Formula(static_cast<Formula::Kind>(job.formulaKind), job.formulaPower, job.juliaReal, job.juliaImag),
+                        m_isRunning, m_mutex, m_threadCount);
+}
+
+// RenderCoordinator
+RenderCoordinator::RenderCoordinator():
+    m_workers(),
+    m_nextJobId(0)
+{}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    for(Worker& worker : m_workers)
+        ::close(worker.socket);
+}
+
+bool RenderCoordinator::connect(const std::vector<std::string> &addresses)
+{
+    for(const std::string& address : addresses)
+    {
+        const int connection = connectTo(address);
+        if(connection >= 0){
+            m_workers.push_back(Worker{connection, false, 0, 0, {}});
+        }else{
+            std::cerr << "Can not reach the worker " << address << '\n';
+        }
+    }
+    return !m_workers.empty();
+}
+
+std::size_t RenderCoordinator::getWorkerCount() const noexcept
+{
+    return m_workers.size();
+}
+
+bool RenderCoordinator::render(const sf::Vector2u imageSize, const sf::Vector2u origin, const sf::Vector2u regionSize,
+                               const double zoom, const sf::Vector2<double> normalizedPosition, const unsigned detailLevel,
+                               const Formula &formula, const Snapshot::Precision precision, FrameVector<unsigned> &iterations)
+{
+    // Whole rows of tiles, at least jobsPerWorker jobs by worker when the region is high enough,
+    // and no more pixels than a worker accepts
+    const unsigned jobCount = std::max<std::size_t>(1, m_workers.size() * jobsPerWorker);
+    const unsigned maximumRows = std::max<std::size_t>(1, RenderWorker::maximumJobPixels / std::max(1u, regionSize.x));
+    const unsigned rowsPerJob = std::min(maximumRows, std::max(kernelTileSize, regionSize.y / jobCount / kernelTileSize * kernelTileSize));
+
+    const sf::Uint32 firstJobId = m_nextJobId;
+    std::vector<Job> jobs;
+    for(unsigned row = 0; row < regionSize.y; row += rowsPerJob)
+    {
+        const RenderJob message { jobMagic, m_nextJobId++, static_cast<sf::Uint32>(precision), detailLevel,
+                                  imageSize.x, imageSize.y, origin.x, origin.y + row,
+                                  regionSize.x, std::min(rowsPerJob, regionSize.y - row),
+                                  zoom, normalizedPosition.x, normalizedPosition.y,
+                                  static_cast<sf::Uint32>(formula.kind), formula.power, formula.juliaReal, formula.juliaImag };
+        jobs.push_back(Job{message, 0, false});
+    }
+
+    iterations.resize(static_cast<std::size_t>(regionSize.x) * regionSize.y);
+    std::size_t nextJob = 0;
+    std::size_t doneCount = 0;
+    std::vector<pollfd> waiting;
+
+    while(doneCount < jobs.size())
+    {
+        for(Worker& worker : m_workers)
+        {
+            if(!worker.busy && !dispatch(worker, jobs, nextJob))
+                disconnect(worker, jobs, firstJobId);
+        }
+        m_workers.erase(std::remove_if(m_workers.begin(), m_workers.end(),
+                                       [](const Worker& worker){ return worker.socket < 0; }), m_workers.end());
+        if(m_workers.empty())
+            return false;
+
+        // Each unfinished job is computed by a worker, or will be given to the next idle one
+        waiting.clear();
+        for(const Worker& worker : m_workers)
+            waiting.push_back(pollfd{worker.socket, static_cast<short>(worker.busy ? POLLIN : 0), 0});
+        {
+            TRACE_SPAN("wait workers");
+            if(poll(waiting.data(), waiting.size(), -1) < 0)
+                continue;
+        }
+
+        for(std::size_t w = 0; w < m_workers.size(); ++w)
+        {
+            Worker& worker = m_workers[w];
+            if(!worker.busy || !(waiting[w].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+
+            const ssize_t received = recv(worker.socket, worker.answer.data() + worker.received,
+                                          worker.answer.size() - worker.received, 0);
+            if(received <= 0){
+                disconnect(worker, jobs, firstJobId);
+                continue;
+            }
+            worker.received += received;
+            if(worker.received < worker.answer.size())
+                continue;
+
+            // Complete answer, unless it is a late one of a previous render or of a job done by another worker
+            AnswerHeader header;
+            std::memcpy(&header, worker.answer.data(), sizeof(header));
+            worker.busy = false;
+            if(header.id < firstJobId || header.id - firstJobId >= jobs.size())
+                continue;
+
+            Job& job = jobs[header.id - firstJobId];
+            --job.copies;
+            const std::size_t pixelCount = static_cast<std::size_t>(job.message.regionWidth) * job.message.regionHeight;
+            if(header.id != worker.jobId || header.pixelCount != pixelCount){
+                disconnect(worker, jobs, firstJobId);
+                continue;
+            }
+            if(!job.done)
+            {
+                const std::size_t first = static_cast<std::size_t>(job.message.originY - origin.y) * regionSize.x;
+                std::memcpy(&iterations[first], worker.answer.data() + sizeof(header), pixelCount * sizeof(unsigned));
+                job.done = true;
+                ++doneCount;
+            }
+        }
+    }
+    return true;
+}
+
+// PRIVATE
+bool RenderCoordinator::dispatch(Worker &worker, std::vector<Job> &jobs, std::size_t &nextJob)
+{
+    std::size_t index = nextJob;
+    if(nextJob < jobs.size()){
+        ++nextJob;
+    }else{
+        // A straggler : the unfinished job computed by the least workers, the first given if equal
+        index = jobs.size();
+        for(std::size_t j = 0; j < jobs.size(); ++j){
+            if(!jobs[j].done && (index == jobs.size() || jobs[j].copies < jobs[index].copies))
+                index = j;
+        }
+        if(index == jobs.size())
+            return true; // Nothing to do
+    }
+
+    Job& job = jobs[index];
+    ++job.copies;
+    worker.busy = true;
+    worker.jobId = job.message.id;
+    worker.received = 0;
+    worker.answer.resize(sizeof(AnswerHeader) + static_cast<std::size_t>(job.message.regionWidth) * job.message.regionHeight * sizeof(unsigned));
+    return sendAll(worker.socket, &job.message, sizeof(job.message));
+}
+
+void RenderCoordinator::disconnect(Worker &worker, std::vector<Job> &jobs, const sf::Uint32 firstJobId)
+{
+    // Its job goes back to the others
+    if(worker.busy && worker.jobId >= firstJobId && worker.jobId - firstJobId < jobs.size())
+        --jobs[worker.jobId - firstJobId].copies;
+
+    ::close(worker.socket);
+    worker.socket = -1;
+    worker.busy = false;
+}
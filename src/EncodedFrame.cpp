@@ -0,0 +1,204 @@
+#include "EncodedFrame.h"
+
+// Std include
+#include <algorithm>
+#include <limits>
+
+// Personal include
+#include "MandelbrotRenderer.h"
+#include "Trace.h"
+
+namespace
+{
+    // Widths of the codes, the highest code of each one is interiorIteration
+    constexpr unsigned codeWidths[4] = {4, 8, 16, 32};
+
+    unsigned codeMask(const unsigned bits) noexcept
+    {
+        return (bits == 32 ? std::numeric_limits<unsigned>::max() : (1u << bits) - 1);
+    }
+
+    template <typename Code>
+    void encodeRow(const unsigned* row, const unsigned width, const unsigned base, const unsigned mask, Code* codes)
+    {
+        for(unsigned x = 0; x < width; ++x)
+            codes[x] = static_cast<Code>(row[x] == interiorIteration ? mask : row[x] - base);
+    }
+
+    // A select without branch, vectorized
+    template <typename Code>
+    void decodeRow(const Code* codes, const unsigned width, const unsigned base, const unsigned mask, unsigned* row)
+    {
+        #pragma omp simd
+        for(unsigned x = 0; x < width; ++x)
+        {
+            const unsigned code = codes[x];
+            row[x] = (code == mask ? interiorIteration : base + code);
+        }
+    }
+}
+
+EncodedFrame::EncodedFrame():
+    m_size(0, 0),
+    m_tiles(),
+    m_codes8(),
+    m_codes16(),
+    m_codes32()
+{}
+
+EncodedFrame::EncodedFrame(const FrameVector<unsigned> &iterations, const sf::Vector2u size, const unsigned threadCount):
+    m_size(size),
+    m_tiles(((size.x + encodedTileSize - 1) / encodedTileSize) * ((size.y + encodedTileSize - 1) / encodedTileSize)),
+    m_codes8(),
+    m_codes16(),
+    m_codes32()
+{
+    TRACE_SPAN("frame encoding");
+    const unsigned tileCount = m_tiles.size();
+
+    // Width of each tile, from the range of its iterations
+    #pragma omp parallel for num_threads(threadCount) schedule(static)
+    for(unsigned t = 0; t < tileCount; ++t)
+    {
+        unsigned x0, y0, width, height;
+        tileRect(t, x0, y0, width, height);
+
+        unsigned lowest = interiorIteration;
+        unsigned highest = 0;
+        bool hasInterior = false;
+        for(unsigned y = y0; y < y0 + height; ++y)
+        {
+            const unsigned* row = &iterations[static_cast<std::size_t>(y) * m_size.x + x0];
+            for(unsigned x = 0; x < width; ++x)
+            {
+                if(row[x] == interiorIteration){
+                    hasInterior = true;
+                }else{
+                    lowest = std::min(lowest, row[x]);
+                    highest = std::max(highest, row[x]);
+                }
+            }
+        }
+
+        Tile &tile = m_tiles[t];
+        if(lowest == interiorIteration || (lowest == highest && !hasInterior)){
+            tile = Tile{0, lowest, 0};
+            continue;
+        }
+        for(const unsigned bits : codeWidths)
+        {
+            if(bits == 32 || highest - lowest < codeMask(bits)){
+                tile = Tile{0, (bits == 32 ? 0 : lowest), bits};
+                break;
+            }
+        }
+    }
+
+    // Place of the codes of each tile. The 4 bits codes of a tile start on a byte
+    std::size_t size8 = 0, size16 = 0, size32 = 0;
+    for(unsigned t = 0; t < tileCount; ++t)
+    {
+        unsigned x0, y0, width, height;
+        tileRect(t, x0, y0, width, height);
+        const std::size_t pixelCount = static_cast<std::size_t>(width) * height;
+
+        Tile &tile = m_tiles[t];
+        switch(tile.bits)
+        {
+            case 4  : tile.offset = size8; size8 += (pixelCount + 1) / 2; break;
+            case 8  : tile.offset = size8; size8 += pixelCount; break;
+            case 16 : tile.offset = size16; size16 += pixelCount; break;
+            case 32 : tile.offset = size32; size32 += pixelCount; break;
+            default : break;
+        }
+    }
+    m_codes8.resize(size8);
+    m_codes16.resize(size16);
+    m_codes32.resize(size32);
+
+    #pragma omp parallel for num_threads(threadCount) schedule(static)
+    for(unsigned t = 0; t < tileCount; ++t)
+    {
+        unsigned x0, y0, width, height;
+        tileRect(t, x0, y0, width, height);
+        const Tile &tile = m_tiles[t];
+        const unsigned mask = codeMask(tile.bits);
+
+        for(unsigned y = 0; y < height; ++y)
+        {
+            const unsigned* row = &iterations[static_cast<std::size_t>(y0 + y) * m_size.x + x0];
+            const std::size_t code = tile.offset + static_cast<std::size_t>(y) * width;
+            switch(tile.bits)
+            {
+                case 4 :
+                    for(unsigned x = 0; x < width; ++x)
+                    {
+                        const unsigned pixel = y * width + x;
+                        const unsigned value = (row[x] == interiorIteration ? mask : row[x] - tile.base);
+                        m_codes8[tile.offset + pixel / 2] |= static_cast<sf::Uint8>(value << (pixel % 2 * 4));
+                    }
+                    break;
+                case 8  : encodeRow(row, width, tile.base, mask, &m_codes8[code]); break;
+                case 16 : encodeRow(row, width, tile.base, mask, &m_codes16[code]); break;
+                case 32 : encodeRow(row, width, tile.base, mask, &m_codes32[code]); break;
+                default : break;
+            }
+        }
+    }
+}
+
+void EncodedFrame::decode(FrameVector<unsigned> &iterations, const unsigned threadCount) const
+{
+    TRACE_SPAN("frame decoding");
+    iterations.resize(static_cast<std::size_t>(m_size.x) * m_size.y);
+    const unsigned tileCount = m_tiles.size();
+
+    #pragma omp parallel for num_threads(threadCount) schedule(static)
+    for(unsigned t = 0; t < tileCount; ++t)
+    {
+        unsigned x0, y0, width, height;
+        tileRect(t, x0, y0, width, height);
+        const Tile &tile = m_tiles[t];
+        const unsigned mask = codeMask(tile.bits);
+
+        for(unsigned y = 0; y < height; ++y)
+        {
+            unsigned* row = &iterations[static_cast<std::size_t>(y0 + y) * m_size.x + x0];
+            const std::size_t code = tile.offset + static_cast<std::size_t>(y) * width;
+            switch(tile.bits)
+            {
+                case 0 :
+                    std::fill(row, row + width, tile.base);
+                    break;
+                case 4 :
+                    #pragma omp simd
+                    for(unsigned x = 0; x < width; ++x)
+                    {
+                        const unsigned pixel = y * width + x;
+                        const unsigned value = (m_codes8[tile.offset + pixel / 2] >> (pixel % 2 * 4)) & mask;
+                        row[x] = (value == mask ? interiorIteration : tile.base + value);
+                    }
+                    break;
+                case 8  : decodeRow(&m_codes8[code], width, tile.base, mask, row); break;
+                case 16 : decodeRow(&m_codes16[code], width, tile.base, mask, row); break;
+                default : std::copy(&m_codes32[code], &m_codes32[code] + width, row); break;
+            }
+        }
+    }
+}
+
+std::size_t EncodedFrame::getByteSize() const noexcept
+{
+    return sizeof(EncodedFrame) + m_tiles.size() * sizeof(Tile) + m_codes8.size()
+         + m_codes16.size() * sizeof(sf::Uint16) + m_codes32.size() * sizeof(sf::Uint32);
+}
+
+// PRIVATE
+void EncodedFrame::tileRect(const unsigned t, unsigned &x0, unsigned &y0, unsigned &width, unsigned &height) const noexcept
+{
+    const unsigned tilesPerRow = (m_size.x + encodedTileSize - 1) / encodedTileSize;
+    x0 = (t % tilesPerRow) * encodedTileSize;
+    y0 = (t / tilesPerRow) * encodedTileSize;
+    width  = std::min(encodedTileSize, m_size.x - x0);
+    height = std::min(encodedTileSize, m_size.y - y0);
+}
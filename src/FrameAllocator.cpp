@@ -0,0 +1,170 @@
+#include "FrameAllocator.h"
+
+// Std include
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+
+// Posix include
+#include <sys/mman.h>
+#include <sched.h>
+#include <unistd.h>
+
+// OpenMP include
+#include <omp.h>
+
+namespace
+{
+    std::atomic<ThreadPlacement::Mode> placementMode(ThreadPlacement::Mode::None);
+    std::atomic<unsigned> placementNode(0);
+
+    // Node of the last binding of the thread, to skip the system call when it doesn't change
+    thread_local int boundNode = -1;
+
+    // "0-3,8-11"
+    cpu_set_t parseCpuList(const std::string &list)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        std::istringstream ranges(list);
+        std::string range;
+        while(std::getline(ranges, range, ','))
+        {
+            const std::size_t dash = range.find('-');
+            const unsigned first = std::strtoul(range.c_str(), nullptr, 10);
+            const unsigned last = (dash == std::string::npos ? first : std::strtoul(range.c_str() + dash + 1, nullptr, 10));
+            for(unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+                CPU_SET(cpu, &cpus);
+        }
+        return cpus;
+    }
+
+    // Processors of each node, read once from sysfs. Empty without NUMA support
+    const std::vector<cpu_set_t>& nodeCpus()
+    {
+        static const std::vector<cpu_set_t> nodes = []{
+            std::vector<cpu_set_t> cpus;
+            for(unsigned node = 0; ; ++node)
+            {
+                std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string list;
+                if(!std::getline(file, list))
+                    break;
+                cpus.push_back(parseCpuList(list));
+            }
+            return cpus;
+        }();
+        return nodes;
+    }
+
+    int nodeOfTeamThread()
+    {
+        const std::vector<cpu_set_t>& nodes = nodeCpus();
+        switch(placementMode.load())
+        {
+            case ThreadPlacement::Mode::Spread :
+                if(nodes.size() < 2)
+                    return -1;
+                return omp_get_thread_num() * nodes.size() / omp_get_num_threads();
+            case ThreadPlacement::Mode::Node :
+                return (placementNode < nodes.size() ? static_cast<int>(placementNode) : -1);
+            default :
+                return -1;
+        }
+    }
+}
+
+bool ThreadPlacement::configure(const std::string &value)
+{
+    if(value == "none"){
+        placementMode = Mode::None;
+    }else if(value == "spread"){
+        placementMode = Mode::Spread;
+    }else if(value.compare(0, 5, "node:") == 0 && value.size() > 5){
+        placementNode = std::strtoul(value.c_str() + 5, nullptr, 10);
+        placementMode = Mode::Node;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+ThreadPlacement::Mode ThreadPlacement::getMode() noexcept
+{
+    return placementMode;
+}
+
+unsigned ThreadPlacement::getNodeCount()
+{
+    return std::max<std::size_t>(nodeCpus().size(), 1);
+}
+
+void ThreadPlacement::bindTeamThread()
+{
+    const int node = nodeOfTeamThread();
+    if(node < 0 || node == boundNode)
+        return;
+    if(sched_setaffinity(0, sizeof(cpu_set_t), &nodeCpus()[node]) == 0)
+        boundNode = node;
+}
+
+ThreadPlacement::TeamScope::TeamScope():
+    m_cpus(),
+    m_boundNode(boundNode),
+    m_restore(placementMode.load() != Mode::None && sched_getaffinity(0, sizeof(cpu_set_t), &m_cpus) == 0)
+{}
+
+ThreadPlacement::TeamScope::~TeamScope()
+{
+    if(m_restore && boundNode != m_boundNode){
+        sched_setaffinity(0, sizeof(cpu_set_t), &m_cpus);
+        boundNode = m_boundNode;
+    }
+}
+
+void* allocateFrameMemory(const std::size_t bytes)
+{
+    // Mapped with a huge page more, to keep the aligned part only
+    const std::size_t length = (bytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+    void* mapping = mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED)
+        throw std::bad_alloc();
+
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(mapping);
+    const std::uintptr_t aligned = (begin + hugePageSize - 1) / hugePageSize * hugePageSize;
+    if(aligned > begin)
+        munmap(mapping, aligned - begin);
+    munmap(reinterpret_cast<void*>(aligned + length), begin + hugePageSize - aligned);
+
+    char* memory = reinterpret_cast<char*>(aligned);
+#ifdef MADV_HUGEPAGE
+    madvise(memory, length, MADV_HUGEPAGE);
+#endif
+
+    // Each page is placed on the node of the thread writing it first. Without placement,
+    // the pages are left to be faulted in by their first use
+    if(placementMode.load() == ThreadPlacement::Mode::None)
+        return memory;
+
+    const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    const long pageCount = length / pageSize;
+    const ThreadPlacement::TeamScope scope;
+
+    #pragma omp parallel num_threads(8)
+    {
+        ThreadPlacement::bindTeamThread();
+
+        #pragma omp for schedule(static)
+        for(long page = 0; page < pageCount; ++page)
+            static_cast<volatile char*>(memory)[page * pageSize] = 0;
+    }
+    return memory;
+}
+
+void freeFrameMemory(void* memory, const std::size_t bytes) noexcept
+{
+    munmap(memory, (bytes + hugePageSize - 1) / hugePageSize * hugePageSize);
+}
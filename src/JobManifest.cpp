@@ -0,0 +1,111 @@
+#include "JobManifest.h"
+
+// Std include
+#include <fstream>
+#include <sstream>
+#include <cstdio> // std::rename
+#include <cstdlib>
+#include <limits>
+
+// Posix include
+#include <fcntl.h>
+#include <unistd.h> // fsync
+
+namespace
+{
+    bool syncPath(const std::string &path, const int flags)
+    {
+        const int descriptor = ::open(path.c_str(), flags);
+        if(descriptor < 0)
+            return false;
+        const bool synced = (fsync(descriptor) == 0);
+        ::close(descriptor);
+        return synced;
+    }
+}
+
+JobManifest::JobManifest():
+    m_values()
+{}
+
+bool JobManifest::load(const std::string &fileName)
+{
+    std::ifstream file(fileName);
+    if(!file)
+        return false;
+
+    m_values.clear();
+    std::string line;
+    while(std::getline(file, line))
+    {
+        const std::size_t space = line.find(' ');
+        if(space != std::string::npos)
+            m_values[line.substr(0, space)] = line.substr(space + 1);
+    }
+    return true;
+}
+
+bool JobManifest::save(const std::string &fileName) const
+{
+    // Written aside, then renamed over the previous manifest
+    const std::string temporaryName = fileName + ".tmp";
+    {
+        std::ofstream file(temporaryName, std::ios::trunc);
+        for(const auto& value : m_values)
+            file << value.first << ' ' << value.second << '\n';
+        file.flush();
+        if(!file)
+            return false;
+    }
+    if(!syncFile(temporaryName) || std::rename(temporaryName.c_str(), fileName.c_str()) != 0)
+        return false;
+
+    // The rename is only durable once the directory is synced
+    const std::size_t slash = fileName.rfind('/');
+    return syncPath((slash == std::string::npos ? "." : fileName.substr(0, slash + 1)), O_RDONLY | O_DIRECTORY);
+}
+
+bool JobManifest::syncFile(const std::string &fileName)
+{
+    return syncPath(fileName, O_RDONLY);
+}
+
+void JobManifest::set(const std::string &key, const std::string &value)
+{
+    m_values[key] = value;
+}
+
+void JobManifest::setNumber(const std::string &key, const double value)
+{
+    // Enough digits to read back the same double
+    std::ostringstream oss;
+    oss.precision(std::numeric_limits<double>::max_digits10);
+    oss << value;
+    m_values[key] = oss.str();
+}
+
+std::string JobManifest::get(const std::string &key) const
+{
+    const auto value = m_values.find(key);
+    return (value == m_values.end() ? std::string() : value->second);
+}
+
+double JobManifest::getNumber(const std::string &key, const double defaultValue) const
+{
+    const auto value = m_values.find(key);
+    return (value == m_values.end() ? defaultValue : std::strtod(value->second.c_str(), nullptr));
+}
+
+void JobManifest::setFormula(const Formula &formula)
+{
+    set("formula", (formula.kind == Formula::Kind::Julia ? "julia" : "mandelbrot"));
+    setNumber("power", formula.power);
+    setNumber("juliaReal", formula.juliaReal);
+    setNumber("juliaImag", formula.juliaImag);
+}
+
+Formula JobManifest::getFormula() const
+{
+    return Formula((get("formula") == "julia" ? Formula::Kind::Julia : Formula::Kind::Mandelbrot),
+                   getNumber("power", 2), getNumber("juliaReal"), getNumber("juliaImag"));
+}
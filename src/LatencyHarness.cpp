@@ -0,0 +1,252 @@
+#include "LatencyHarness.h"
+
+// Std include
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+// Sfml include
+// - System
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+namespace
+{
+    // Nearest rank, values sorted
+    double percentile(const std::vector<double> &values, const double p)
+    {
+        const std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100 * values.size()));
+        return values[std::max<std::size_t>(rank, 1) - 1];
+    }
+
+    sf::Event keyEvent(const sf::Keyboard::Key key, const bool shift = false)
+    {
+        sf::Event event;
+        event.type = sf::Event::KeyPressed;
+        event.key.code = key;
+        event.key.alt = event.key.control = event.key.system = false;
+        event.key.shift = shift;
+        return event;
+    }
+
+    sf::Event mouseEvent(const sf::Event::EventType type, const int x, const int y)
+    {
+        sf::Event event;
+        event.type = type;
+        if(type == sf::Event::MouseMoved){
+            event.mouseMove.x = x;
+            event.mouseMove.y = y;
+        }else{
+            event.mouseButton.button = sf::Mouse::Left;
+            event.mouseButton.x = x;
+            event.mouseButton.y = y;
+        }
+        return event;
+    }
+}
+
+LatencyHarness::LatencyHarness(sf::RenderWindow &window, Application &application):
+    m_window(window),
+    m_application(application),
+    m_steps(),
+    m_measures(),
+    m_nextPause()
+{}
+
+bool LatencyHarness::loadScript(const std::string &fileName)
+{
+    std::ifstream file(fileName);
+    if(!file)
+        return false;
+
+    m_steps.clear();
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(!parseLine(line.substr(0, line.find('#'))))
+            return false;
+    }
+    return true;
+}
+
+void LatencyHarness::loadDefaultScript()
+{
+    m_steps.clear();
+    for(const char* line : {"zoom 10", "wait 200", "pan right 5", "pan down 5", "wait 500",
+                            "pan left 3", "unzoom 4", "wait 200", "detail 20", "unzoom 6"})
+        parseLine(line);
+}
+
+void LatencyHarness::run()
+{
+    // From a finished rendering, as a user would
+    while(m_window.isOpen() && !m_application.isIdle())
+    {
+        m_application.update();
+        if(m_application.needRedraw()){
+            m_window.clear();
+            m_application.draw();
+            m_window.display();
+        }else{
+            m_application.handleEvent();
+        }
+    }
+
+    m_measures.clear();
+    for(const Step& step : m_steps)
+    {
+        if(!m_window.isOpen())
+            break;
+        m_measures.push_back(runStep(step));
+    }
+}
+
+void LatencyHarness::printReport(std::ostream &output) const
+{
+    std::vector<std::string> kinds;
+    for(const Measure& measure : m_measures){
+        if(std::find(kinds.begin(), kinds.end(), measure.kind) == kinds.end())
+            kinds.push_back(measure.kind);
+    }
+    kinds.push_back("all");
+
+    output << std::fixed << std::setprecision(1)
+           << std::left << std::setw(8) << "input" << std::right << std::setw(6) << "count"
+           << "   preview p50    p90    p99    max" << "   final p50    p90    p99    max  (ms)\n";
+
+    for(const std::string& kind : kinds)
+    {
+        std::vector<double> previews;
+        std::vector<double> finals;
+        for(const Measure& measure : m_measures){
+            if(kind == "all" || measure.kind == kind){
+                previews.push_back(measure.preview);
+                if(measure.final >= 0)
+                    finals.push_back(measure.final);
+            }
+        }
+        if(previews.empty())
+            continue;
+        std::sort(previews.begin(), previews.end());
+        std::sort(finals.begin(), finals.end());
+
+        output << std::left << std::setw(8) << kind << std::right << std::setw(6) << previews.size() << "   ";
+        for(const std::vector<double>* values : {&previews, &finals})
+        {
+            if(values->empty()){
+                output << std::setw(11) << '-' << std::setw(7) << '-' << std::setw(7) << '-' << std::setw(7) << '-' << "   ";
+                continue;
+            }
+            output << std::setw(11) << percentile(*values, 50) << std::setw(7) << percentile(*values, 90)
+                   << std::setw(7) << percentile(*values, 99) << std::setw(7) << values->back() << "   ";
+        }
+        output << '\n';
+    }
+}
+
+// PRIVATE
+bool LatencyHarness::parseLine(const std::string &line)
+{
+    std::istringstream words(line);
+    std::string command;
+    if(!(words >> command))
+        return true; // Empty line
+
+    if(command == "zoom" || command == "unzoom"){
+        unsigned count = 1;
+        words >> count;
+        addKeySteps(command, (command == "zoom" ? sf::Keyboard::Z : sf::Keyboard::S), count);
+    }else if(command == "pan"){
+        std::string direction;
+        unsigned count = 1;
+        words >> direction >> count;
+        if(direction == "left")
+            addKeySteps(command, sf::Keyboard::Left, count);
+        else if(direction == "right")
+            addKeySteps(command, sf::Keyboard::Right, count);
+        else if(direction == "up")
+            addKeySteps(command, sf::Keyboard::Up, count);
+        else if(direction == "down")
+            addKeySteps(command, sf::Keyboard::Down, count);
+        else
+            return false;
+    }else if(command == "detail"){
+        int count = 1;
+        words >> count;
+        addKeySteps(command, (count < 0 ? sf::Keyboard::Q : sf::Keyboard::A), std::abs(count));
+    }else if(command == "box"){
+        int x = 0, y = 0, width = 0, height = 0;
+        if(!(words >> x >> y >> width >> height))
+            return false;
+        m_steps.push_back(Step{command, {mouseEvent(sf::Event::MouseButtonPressed, x, y),
+                                         mouseEvent(sf::Event::MouseMoved, x + width, y + height),
+                                         mouseEvent(sf::Event::MouseButtonReleased, x + width, y + height)},
+                               m_nextPause, sf::Keyboard::Unknown, false});
+        m_nextPause = sf::Time();
+    }else if(command == "screenshot"){
+        std::string size;
+        words >> size;
+        m_steps.push_back(Step{command, {keyEvent(sf::Keyboard::E, size == "large")}, m_nextPause,
+                               sf::Keyboard::Unknown, false});
+        m_nextPause = sf::Time();
+    }else if(command == "wait"){
+        int milliseconds = 0;
+        words >> milliseconds;
+        m_nextPause += sf::milliseconds(milliseconds);
+    }else{
+        return false;
+    }
+    return true;
+}
+
+void LatencyHarness::addKeySteps(const std::string &kind, const sf::Keyboard::Key key, const unsigned count)
+{
+    for(unsigned i = 0; i < count; ++i)
+    {
+        m_steps.push_back(Step{kind, {keyEvent(key)}, m_nextPause, key, i + 1 == count});
+        m_nextPause = sf::Time();
+    }
+}
+
+LatencyHarness::Measure LatencyHarness::runStep(const Step &step)
+{
+    sf::sleep(step.pause);
+
+    const bool held = (step.heldKey != sf::Keyboard::Unknown);
+    if(held)
+        m_application.simulateKey(step.heldKey, true);
+
+    sf::Clock clock;
+    for(const sf::Event& event : step.events)
+        m_application.simulateEvent(event);
+
+    Measure measure { step.kind, -1, -1 };
+    while(m_window.isOpen())
+    {
+        m_application.update();
+        if(m_application.needRedraw()){
+            m_window.clear();
+            m_application.draw();
+            m_window.display();
+            // A redraw of the previous view isn't a preview
+            if(measure.preview < 0 && m_application.isViewShown()){
+                measure.preview = clock.getElapsedTime().asMicroseconds() / 1000.0;
+                if(held && !step.release)
+                    return measure; // The next press comes while the key is held
+                if(held)
+                    m_application.simulateKey(step.heldKey, false);
+            }
+        }
+
+        if(m_application.isIdle())
+            break;
+        m_application.handleEvent(); // Waits for the rendering, or for the next frame
+    }
+
+    measure.final = clock.getElapsedTime().asMicroseconds() / 1000.0;
+    if(measure.preview < 0)
+        measure.preview = measure.final;
+    return measure;
+}
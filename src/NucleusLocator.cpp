@@ -0,0 +1,248 @@
+#include "NucleusLocator.h"
+
+// Std include
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <algorithm>
+
+// Personal include
+#include "MandelbrotRenderer.h"
+#include "Snapshot.h"
+
+namespace
+{
+    // Newton's method converges in a few steps from a point in the view of its nucleus
+    constexpr unsigned maximumNewtonSteps = 64;
+
+    // Periods tried when Newton leaves the view, the disc may hold the nucleus of a higher one
+    constexpr unsigned maximumCandidates = 8;
+
+    // Nucleus between two precisions : a double and the rest, enough to start Newton again
+    struct Estimate
+    {
+        unsigned period;
+        double real[2];
+        double imag[2];
+    };
+
+    Snapshot::Precision precisionOf(const double zoom) noexcept
+    {
+        if(zoom < float128RenderBeginning)
+            return Snapshot::Precision::Double; // Too close to the periodic points for float
+        else if(zoom < gmpRenderBeginning)
+            return Snapshot::Precision::Float128;
+        return Snapshot::Precision::Gmp;
+    }
+
+    // Relative precision of the number type
+    template <typename T>
+    double epsilonOf(const T &) { return std::numeric_limits<double>::epsilon(); }
+    double epsilonOf(const __float128 &) { return std::ldexp(1.0, -112); }
+    double epsilonOf(const mpf_class &value) { return std::ldexp(1.0, -static_cast<int>(value.get_prec())); }
+
+    template <typename T>
+    void split(const T &value, double parts[2])
+    {
+        parts[0] = NumberTraits<T>::toDouble(value);
+        parts[1] = NumberTraits<T>::toDouble(value - T(parts[0]));
+    }
+
+    // First n from firstPeriod at which the disc of this radius around c may hold a nucleus of period n :
+    // |z_n| is smaller than the radius of the image of the disc, |dz_n/dc| * radius. 0 if none
+    template <typename T>
+    unsigned findPeriod(const T &c_r, const T &c_i, const double radius, const unsigned firstPeriod,
+                        const unsigned maximumPeriod)
+    {
+        T z_r(0), z_i(0);
+        double d_r = 0, d_i = 0;
+        for(unsigned n = 1; n <= maximumPeriod; ++n)
+        {
+            const double zd_r = NumberTraits<T>::toDouble(z_r);
+            const double zd_i = NumberTraits<T>::toDouble(z_i);
+            const double next_d_r = 2 * (zd_r * d_r - zd_i * d_i) + 1;
+            d_i = 2 * (zd_r * d_i + zd_i * d_r);
+            d_r = next_d_r;
+
+            const T next_z_r = z_r * z_r - z_i * z_i + c_r;
+            z_i = 2 * z_r * z_i + c_i;
+            z_r = next_z_r;
+
+            const double distance = std::hypot(NumberTraits<T>::toDouble(z_r), NumberTraits<T>::toDouble(z_i));
+            const double spread = radius * std::hypot(d_r, d_i);
+            if(distance < spread && n >= firstPeriod)
+                return n;
+            if(distance - spread > 2) // The whole disc escaped
+                return 0;
+        }
+        return 0;
+    }
+
+    // Solve z_period(c) = 0, until the step is under the tolerance or the precision of T.
+    // The step z / (dz/dc) is small, so it is computed in double
+    template <typename T>
+    bool newton(T &c_r, T &c_i, const unsigned period, double tolerance)
+    {
+        const double magnitude = std::max(1.0, std::hypot(NumberTraits<T>::toDouble(c_r), NumberTraits<T>::toDouble(c_i)));
+        tolerance = std::max(tolerance, 16 * epsilonOf(c_r) * magnitude);
+
+        for(unsigned step = 0; step < maximumNewtonSteps; ++step)
+        {
+            T z_r(0), z_i(0);
+            double d_r = 0, d_i = 0;
+            for(unsigned n = 0; n < period; ++n)
+            {
+                const double zd_r = NumberTraits<T>::toDouble(z_r);
+                const double zd_i = NumberTraits<T>::toDouble(z_i);
+                const double next_d_r = 2 * (zd_r * d_r - zd_i * d_i) + 1;
+                d_i = 2 * (zd_r * d_i + zd_i * d_r);
+                d_r = next_d_r;
+
+                const T next_z_r = z_r * z_r - z_i * z_i + c_r;
+                z_i = 2 * z_r * z_i + c_i;
+                z_r = next_z_r;
+            }
+
+            const double zd_r = NumberTraits<T>::toDouble(z_r);
+            const double zd_i = NumberTraits<T>::toDouble(z_i);
+            const double norm = d_r * d_r + d_i * d_i;
+            const double step_r = (zd_r * d_r + zd_i * d_i) / norm;
+            const double step_i = (zd_i * d_r - zd_r * d_i) / norm;
+            if(!std::isfinite(step_r) || !std::isfinite(step_i))
+                return false;
+
+            c_r -= step_r;
+            c_i -= step_i;
+            if(std::hypot(step_r, step_i) <= tolerance)
+                return true;
+        }
+        return false;
+    }
+
+    // size = 1 / (b * l^2), l the derivative of the cycle by z and b the sum of the inverses of its partial products.
+    // http://mathr.co.uk/blog/2013-12-10_atom_domain_size_estimation.html
+    template <typename T>
+    sf::Vector2<double> minibrotSize(const T &c_r, const T &c_i, const unsigned period)
+    {
+        T z_r(0), z_i(0);
+        std::complex<double> l(1, 0);
+        std::complex<double> b(1, 0);
+        for(unsigned n = 1; n < period; ++n)
+        {
+            const T next_z_r = z_r * z_r - z_i * z_i + c_r;
+            z_i = 2 * z_r * z_i + c_i;
+            z_r = next_z_r;
+
+            l *= 2.0 * std::complex<double>(NumberTraits<T>::toDouble(z_r), NumberTraits<T>::toDouble(z_i));
+            b += 1.0 / l;
+        }
+        const std::complex<double> size = 1.0 / (b * l * l);
+        return sf::Vector2<double>(size.real(), size.imag());
+    }
+
+    // Period and nucleus of the view, in its number type
+    template <typename T>
+    bool detectWith(const sf::Vector2u dataSize, const double zoom, const sf::Vector2<double> normalizedPosition,
+                    const unsigned maximumPeriod, Estimate &estimate, Nucleus &nucleus)
+    {
+        NumberTraits<T>::setPrecision(precisionForZoom(zoom, dataSize.y));
+        const ViewGeometry<T> geometry(dataSize, zoom, normalizedPosition);
+        const T center_r = geometry.real(dataSize.x / 2);
+        const T center_i = geometry.imag(dataSize.y / 2);
+        const double radius = geometry.pixelSize() * std::hypot(dataSize.x, dataSize.y) / 2;
+
+        T c_r = center_r;
+        T c_i = center_i;
+        unsigned period = 0;
+        for(unsigned candidate = 0; candidate < maximumCandidates; ++candidate)
+        {
+            period = findPeriod(center_r, center_i, radius, period + 1, maximumPeriod);
+            if(period == 0)
+                return false;
+
+            // Newton may converge to a nucleus of this period out of the view
+            c_r = center_r;
+            c_i = center_i;
+            if(newton(c_r, c_i, period, radius * 1e-9)){
+                const T offset_r = c_r - center_r;
+                const T offset_i = c_i - center_i;
+                if(std::hypot(NumberTraits<T>::toDouble(offset_r), NumberTraits<T>::toDouble(offset_i)) <= radius)
+                    break;
+            }
+            if(candidate + 1 == maximumCandidates)
+                return false;
+        }
+
+        estimate.period = period;
+        split(c_r, estimate.real);
+        split(c_i, estimate.imag);
+        nucleus = Nucleus{period, sf::Vector2<double>(estimate.real[0], estimate.imag[0]), minibrotSize(c_r, c_i, period)};
+        return true;
+    }
+
+    // Newton again, at the precision of the zoom of the minibrot
+    template <typename T>
+    bool refineWith(const sf::Vector2u dataSize, const double zoom, const Estimate &estimate, Nucleus &nucleus)
+    {
+        NumberTraits<T>::setPrecision(precisionForZoom(zoom, dataSize.y));
+        T c_r = T(estimate.real[0]) + T(estimate.real[1]);
+        T c_i = T(estimate.imag[0]) + T(estimate.imag[1]);
+        if(!newton(c_r, c_i, estimate.period, 1e-9 / zoom))
+            return false;
+
+        nucleus.position = sf::Vector2<double>(NumberTraits<T>::toDouble(c_r), NumberTraits<T>::toDouble(c_i));
+        nucleus.size = minibrotSize(c_r, c_i, estimate.period);
+        return true;
+    }
+}
+
+bool locateNucleus(const sf::Vector2u dataSize, const double zoom, const sf::Vector2<double> normalizedPosition,
+                   const unsigned maximumPeriod, Nucleus &nucleus)
+{
+    TRACE_SPAN("locate nucleus");
+
+    Estimate estimate;
+    const Snapshot::Precision viewPrecision = precisionOf(zoom);
+    bool found = false;
+    switch(viewPrecision)
+    {
+        case Snapshot::Precision::Float128 :
+            found = detectWith<__float128>(dataSize, zoom, normalizedPosition, maximumPeriod, estimate, nucleus);
+            break;
+        case Snapshot::Precision::Gmp :
+            found = detectWith<mpf_class>(dataSize, zoom, normalizedPosition, maximumPeriod, estimate, nucleus);
+            break;
+        default :
+            found = detectWith<double>(dataSize, zoom, normalizedPosition, maximumPeriod, estimate, nucleus);
+            break;
+    }
+    if(!found)
+        return false;
+
+    const double minibrotZoom = 1 / std::hypot(nucleus.size.x, nucleus.size.y);
+    if(minibrotZoom > maximumMinibrotZoom)
+        return false;
+
+    // The minibrot is shallower than GMP, which is only used to detect it in a deeper view
+    const Snapshot::Precision minibrotPrecision = precisionOf(minibrotZoom);
+    if(minibrotZoom <= zoom || minibrotPrecision == viewPrecision)
+        return true;
+
+    switch(minibrotPrecision)
+    {
+        case Snapshot::Precision::Float128 : return refineWith<__float128>(dataSize, minibrotZoom, estimate, nucleus);
+        default                            : return refineWith<double>(dataSize, minibrotZoom, estimate, nucleus);
+    }
+}
+
+void nucleusView(const Nucleus &nucleus, const sf::Vector2u dataSize, double &zoom, sf::Vector2<double> &normalizedPosition)
+{
+    // The center of the first view, relative to the nucleus 0 of the whole set
+    const ViewGeometry<double> home(dataSize, 1, sf::Vector2<double>(0.4, 0.5));
+    const std::complex<double> homeCenter(home.real(dataSize.x / 2), home.imag(dataSize.y / 2));
+
+    const std::complex<double> size(nucleus.size.x, nucleus.size.y);
+    const std::complex<double> center = std::complex<double>(nucleus.position.x, nucleus.position.y) + size * homeCenter;
+    zoom = 1 / std::abs(size);
+    normalizedPosition = ViewGeometry<double>::normalizedPositionOf(dataSize, center.real(), center.imag());
+}
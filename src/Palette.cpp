@@ -0,0 +1,126 @@
+#include "Palette.h"
+
+// Std include
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "omp.h"
+
+// Personal include
+#include "Trace.h"
+
+Palette::Palette():
+    m_table(),
+    m_tableDetailLevel(0),
+    m_mode(Mode::Linear)
+{}
+
+void Palette::setMode(Mode mode) noexcept
+{
+    if(mode != m_mode){
+        m_mode = mode;
+        m_tableDetailLevel = 0;
+    }
+}
+
+Palette::Mode Palette::getMode() const noexcept
+{
+    return m_mode;
+}
+
+void Palette::colorize(const FrameVector<unsigned> &iterations, const FrameVector<float> &distance,
+                       FrameVector<sf::Uint8> &data, const unsigned detailLevel)
+{
+    TRACE_SPAN("colorize");
+
+    // The linear table only depends on the detail level, the equalized one on the whole frame
+    if(m_mode == Mode::HistogramEqualized){
+        buildEqualizedTable(iterations, detailLevel);
+    }else if(m_tableDetailLevel != detailLevel){
+        buildLinearTable(detailLevel);
+    }
+
+    const bool lightBoundary = !distance.empty();
+    const unsigned pixelCount = iterations.size();
+
+    // Same parts of the frame as the first touch of its pages
+    const ThreadPlacement::TeamScope scope;
+    #pragma omp parallel num_threads(8)
+    {
+        ThreadPlacement::bindTeamThread();
+
+        #pragma omp for schedule(static)
+        for(unsigned pixel = 0; pixel < pixelCount; ++pixel)
+        {
+            const unsigned i = std::min(iterations[pixel], detailLevel); // Also interiorIteration
+            sf::Uint8* color = &data[pixel * 4];
+            std::memcpy(color, &m_table[i * 4], 4);
+
+            if(lightBoundary && i < detailLevel)
+            {
+                // Light up the pixels closer than 2 pixels to the boundary,
+                // so the thin filaments missed by the escape time become visible
+                const double shade = std::min(1.0, std::sqrt(distance[pixel] / 2.0));
+                for(unsigned c = 0; c < 3; ++c)
+                    color[c] = static_cast<sf::Uint8>(color[c] * shade + 255 * (1 - shade));
+            }
+        }
+    }
+}
+
+// PRIVATE
+void Palette::buildLinearTable(const unsigned detailLevel)
+{
+    m_table.resize((detailLevel + 1) * 4);
+    for(unsigned i = 0; i < detailLevel; ++i){
+        setColor(i, static_cast<double>(i)/static_cast<double>(detailLevel));
+    }
+    std::fill(m_table.end() - 4, m_table.end() - 1, 0);
+    m_table.back() = 255;
+
+    m_tableDetailLevel = detailLevel;
+}
+
+void Palette::buildEqualizedTable(const FrameVector<unsigned> &iterations, const unsigned detailLevel)
+{
+    std::vector<unsigned> histogram(detailLevel + 1, 0);
+    const unsigned pixelCount = iterations.size();
+
+    #pragma omp parallel num_threads(8)
+    {
+        std::vector<unsigned> localHistogram(detailLevel + 1, 0);
+
+        #pragma omp for schedule(static)
+        for(unsigned pixel = 0; pixel < pixelCount; ++pixel)
+            ++localHistogram[std::min(iterations[pixel], detailLevel)];
+
+        #pragma omp critical
+        for(unsigned i = 0; i <= detailLevel; ++i)
+            histogram[i] += localHistogram[i];
+    }
+
+    unsigned escaped = 0;
+    for(unsigned i = 0; i < detailLevel; ++i)
+        escaped += histogram[i];
+
+    m_table.resize((detailLevel + 1) * 4);
+    unsigned before = 0;
+    for(unsigned i = 0; i < detailLevel; ++i){
+        setColor(i, escaped == 0 ? 0.0 : static_cast<double>(before)/static_cast<double>(escaped));
+        before += histogram[i];
+    }
+    std::fill(m_table.end() - 4, m_table.end() - 1, 0);
+    m_table.back() = 255;
+
+    m_tableDetailLevel = 0; // Depends on the frame, never reused
+}
+
+void Palette::setColor(const unsigned index, const double t)
+{
+    // Use smooth polynomials for r, g, b
+    m_table[index * 4]     = static_cast<sf::Uint8>(9*(1-t)*t*t*t*255);
+    m_table[index * 4 + 1] = static_cast<sf::Uint8>(15*(1-t)*(1-t)*t*t*255);
+    m_table[index * 4 + 2] = static_cast<sf::Uint8>(8.5*(1-t)*(1-t)*(1-t)*t*255);
+    m_table[index * 4 + 3] = static_cast<sf::Uint8>(255);
+}
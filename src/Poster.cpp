@@ -0,0 +1,199 @@
+#include "Poster.h"
+
+// Std include
+#include <algorithm>
+#include <iostream>
+#include <cstdio> // std::remove
+
+// Personal include
+#include "TiffWriter.h"
+#include "JobManifest.h"
+#include "Trace.h"
+
+#include "omp.h"
+
+namespace
+{
+    // Pixels of a band, whose iterations, RGBA and RGB take 11 bytes by pixel
+    constexpr unsigned maximumBandPixels = 1 << 24;
+
+    // Height of the screens for which the precision thresholds are given
+    constexpr double thresholdHeight = 1080;
+}
+
+Poster::Poster(const sf::Vector2u size, const double zoom, const sf::Vector2<double> normalizedPosition,
+               const unsigned detailLevel, const Formula &formula):
+    m_iterations(),
+    m_data(),
+    m_rgb(),
+    m_palette(),
+    m_size(size),
+    m_normalizedPosition(normalizedPosition),
+    m_scale(zoom),
+    m_detailLevel(detailLevel),
+    m_formula(formula),
+    m_isRunning(true),
+    m_mutex(),
+    m_coordinator(nullptr)
+{
+    // The equalized palette needs the histogram of the whole image,
+    // which isn't known before the last band
+    m_palette.setMode(Palette::Mode::Linear);
+}
+
+bool Poster::render(const std::string &fileName)
+{
+    return renderFrom(fileName, 0);
+}
+
+bool Poster::renderPixels(std::vector<sf::Uint8> &pixels)
+{
+    pixels.resize(static_cast<std::size_t>(m_size.x) * m_size.y * 4);
+    const unsigned bandHeight = getBandHeight();
+    for(unsigned firstRow = 0; firstRow < m_size.y; firstRow += bandHeight)
+    {
+        TRACE_SPAN_ARG("band", firstRow / bandHeight);
+        if(!renderBand(firstRow, std::min(bandHeight, m_size.y - firstRow)))
+            return false;
+        std::copy(m_data.begin(), m_data.end(), pixels.begin() + static_cast<std::size_t>(firstRow) * m_size.x * 4);
+    }
+    return true;
+}
+
+void Poster::setCoordinator(RenderCoordinator* coordinator) noexcept
+{
+    m_coordinator = coordinator;
+}
+
+sf::Vector2u Poster::getSize() const noexcept
+{
+    return m_size;
+}
+
+bool Poster::resume(const std::string &manifestName, RenderCoordinator* coordinator)
+{
+    JobManifest manifest;
+    if(!manifest.load(manifestName) || manifest.get("job") != "poster")
+        return false;
+
+    const sf::Vector2u size(manifest.getNumber("width"), manifest.getNumber("height"));
+    const sf::Vector2<double> position(manifest.getNumber("positionX"), manifest.getNumber("positionY"));
+    Poster poster(size, manifest.getNumber("zoom"), position, manifest.getNumber("detailLevel"), manifest.getFormula());
+
+    // The strips are placed from the band height, which must not change
+    if(poster.getBandHeight() != manifest.getNumber("bandHeight"))
+        return false;
+
+    poster.setCoordinator(coordinator);
+    return poster.renderFrom(manifest.get("file"), manifest.getNumber("nextBand"));
+}
+
+// PRIVATE
+bool Poster::renderFrom(const std::string &fileName, const unsigned firstBand)
+{
+    TiffWriter writer;
+    if(!writer.open(fileName, m_size, getBandHeight(), firstBand != 0))
+        return false;
+
+    JobManifest manifest;
+    const std::string manifestName = fileName + ".job";
+    manifest.set("job", "poster");
+    manifest.set("file", fileName);
+    manifest.setNumber("width", m_size.x);
+    manifest.setNumber("height", m_size.y);
+    manifest.setNumber("zoom", m_scale);
+    manifest.setNumber("positionX", m_normalizedPosition.x);
+    manifest.setNumber("positionY", m_normalizedPosition.y);
+    manifest.setNumber("detailLevel", m_detailLevel);
+    manifest.setFormula(m_formula);
+    manifest.setNumber("bandHeight", getBandHeight());
+
+    const unsigned bandCount = writer.getStripCount();
+    for(unsigned band = firstBand; band < bandCount; ++band)
+    {
+        TRACE_SPAN_ARG("band", band);
+        const unsigned rows = writer.getStripRows(band);
+        // The band is in the file before the manifest says so
+        if(!renderBand(band * getBandHeight(), rows) || !writer.writeStrip(band, m_rgb) || !writer.flush())
+            return false;
+        manifest.setNumber("nextBand", band + 1);
+        manifest.save(manifestName);
+
+        std::cout << band + 1 << " / " << bandCount << '\n';
+    }
+
+    if(!writer.close())
+        return false;
+    std::remove(manifestName.c_str());
+    return true;
+}
+
+Snapshot::Precision Poster::getPrecision() const noexcept
+{
+    // The thresholds depend on the size of the pixels, so on the height of the image
+    const double precisionZoom = m_scale * m_size.y / thresholdHeight;
+    if(precisionZoom < doubleRenderBeginning)
+        return Snapshot::Precision::Float;
+    else if(precisionZoom < float128RenderBeginning)
+        return Snapshot::Precision::Double;
+    else if(precisionZoom < gmpRenderBeginning)
+        return Snapshot::Precision::Float128;
+    else
+        return Snapshot::Precision::Gmp;
+}
+
+unsigned Poster::getBandHeight() const noexcept
+{
+    const unsigned rows = std::max(1u, maximumBandPixels / std::max(1u, m_size.x));
+    if(rows >= m_size.y)
+        return m_size.y;
+    // Whole rows of tiles when the image is narrow enough
+    return (rows > kernelTileSize ? rows / kernelTileSize * kernelTileSize : rows);
+}
+
+bool Poster::renderBand(const unsigned firstRow, const unsigned rows)
+{
+    const unsigned pixelCount = m_size.x * rows;
+    m_iterations.resize(pixelCount);
+    m_data.resize(pixelCount * 4);
+    m_rgb.resize(pixelCount * 3);
+
+    if(m_coordinator){
+        if(!m_coordinator->render(m_size, sf::Vector2u(0, firstRow), sf::Vector2u(m_size.x, rows), m_scale,
+                                  m_normalizedPosition, m_detailLevel, m_formula, getPrecision(), m_iterations))
+            return false;
+    }else{
+        // The window may be rendering in GMP, each band waits for its turn
+        std::unique_lock<std::mutex> gmpLock(gmpPrecisionMutex(), std::defer_lock);
+        if(getPrecision() == Snapshot::Precision::Gmp && !lockGmpPrecision(gmpLock, m_isRunning, m_mutex))
+            return false;
+
+        switch(getPrecision())
+        {
+            case Snapshot::Precision::Float    : renderBandWith<float>(firstRow, rows); break;
+            case Snapshot::Precision::Double   : renderBandWith<double>(firstRow, rows); break;
+            case Snapshot::Precision::Float128 : renderBandWith<__float128>(firstRow, rows); break;
+            default                            : renderBandWith<mpf_class>(firstRow, rows); break;
+        }
+    }
+
+    m_palette.colorize(m_iterations, FrameVector<float>(), m_data, m_detailLevel);
+
+    TRACE_SPAN("rgb packing");
+    #pragma omp parallel for num_threads(8) schedule(static)
+    for(unsigned pixel = 0; pixel < pixelCount; ++pixel)
+    {
+        m_rgb[pixel * 3]     = m_data[pixel * 4];
+        m_rgb[pixel * 3 + 1] = m_data[pixel * 4 + 1];
+        m_rgb[pixel * 3 + 2] = m_data[pixel * 4 + 2];
+    }
+    return true;
+}
+
+template <typename T>
+void Poster::renderBandWith(const unsigned firstRow, const unsigned rows)
+{
+    IterationOutput<T> output { m_iterations };
+    mandelbrotKernel<T>(output, m_size, sf::Vector2u(0, firstRow), sf::Vector2u(m_size.x, rows),
+                        m_scale, m_detailLevel, 0, m_normalizedPosition, m_formula, m_isRunning, m_mutex);
+}
@@ -5,30 +5,84 @@
 #include <stdexcept>
 #include <quadmath.h>
 #include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+
+// Sfml include
+// - System
+#include <SFML/System/Clock.hpp>
+
+// Posix include
+#include <sys/resource.h> // setpriority
 
 // Personal include
 #include "RenderThread.h"
 #include "MandelbrotRenderer.h"
+#include "Trace.h"
 
+namespace
+{
+    // The orbits of a complete frame, null if there are none
+    template <typename T>
+    const void* getOrbitData(const FrameVector<OrbitState<T>> &orbits, const std::size_t pixelCount)
+    {
+        return (orbits.size() == pixelCount ? orbits.data() : nullptr);
+    }
+
+    template <typename T>
+    void loadOrbits(const Snapshot &snapshot, FrameVector<OrbitState<T>> &orbits, const std::size_t pixelCount)
+    {
+        if(snapshot.getOrbits() && snapshot.getOrbitSize() == sizeof(OrbitState<T>)){
+            const OrbitState<T>* first = static_cast<const OrbitState<T>*>(snapshot.getOrbits());
+            orbits.assign(first, first + pixelCount);
+        }
+    }
+}
 
 Render::Render(const unsigned width, const unsigned height):
     m_data(width * height * 4, 0),
+    m_iterations(width * height, 0),
+    m_distance(),
+    m_floatOrbits(),
+    m_doubleOrbits(),
+    m_float128Orbits(),
+    m_gmpOrbits(),
+    m_renderedView{0, sf::Vector2<double>(), 0},
+    m_palette(),
     m_imageSize(width, height),
     m_texture(),
     m_isRenderingFinished(true),
+    m_previewIterations(),
+    m_previewData(),
+    m_previewTexture(),
+    m_previewRun(false),
     m_normalizedPosition(0.4, 0.5),
     m_gmp_normalizedPosition(),
     m_scale(1.0),
     m_detailLevel(30),
-    m_autoAdjustDetail(true),
+    m_detailMode(DetailMode::Zoom),
+    m_histogramDetailValid(false),
+    m_estimateDistance(false),
+    m_formula(),
     m_renderThread(&Render::launchRendering, this),
     m_threadRun(false),
-    m_mutexForBoolean()
+    m_cache(),
+    m_prefetchQueue(),
+    m_prefetchIterations(),
+    m_prefetchThread(&Render::launchPrefetch, this),
+    m_prefetchRun(false),
+    m_prefetchThreadCount(2),
+    m_cacheBudget(128 << 20),
+    m_mutexForBoolean(),
+    m_finishedMutex(),
+    m_renderingFinished()
 {
     m_detailLevel = getDetailForZoom(m_scale);
-    if(m_texture.create(m_imageSize.x, m_imageSize.y))
+    if(m_texture.create(m_imageSize.x, m_imageSize.y) && m_previewTexture.create(m_imageSize.x, m_imageSize.y))
     {
         m_texture.setSmooth(false);
+        m_previewTexture.setSmooth(true); // Stretched to the window
     }
     else
     {
@@ -42,12 +96,16 @@ Render::Render(const sf::Vector2u size):
 {}
 
 Render::~Render()
-{}
+{
+    // The threads use the cache and the buffers, which are destroyed before them
+    abort();
+}
 
 void Render::setZoom(double zoom) noexcept
 {
     m_scale = zoom;
-    if(m_autoAdjustDetail)
+    m_histogramDetailValid = false;
+    if(m_detailMode == DetailMode::Zoom)
         m_detailLevel = getDetailForZoom(zoom);
 }
 
@@ -68,17 +126,190 @@ unsigned Render::getDetailLevel() const noexcept
 
 void Render::setAutoAdjustDetail(bool autoAdj) noexcept
 {
-     m_autoAdjustDetail = autoAdj;
+     setDetailMode(autoAdj ? DetailMode::Zoom : DetailMode::Manual);
 }
 
 bool Render::autoAdjustDetail() const noexcept
 {
-    return m_autoAdjustDetail;
+    return m_detailMode != DetailMode::Manual;
+}
+
+void Render::setDetailMode(DetailMode mode) noexcept
+{
+    m_detailMode = mode;
+    m_histogramDetailValid = false;
+}
+
+Render::DetailMode Render::getDetailMode() const noexcept
+{
+    return m_detailMode;
+}
+
+void Render::setDistanceEstimation(bool estimate) noexcept
+{
+    m_estimateDistance = estimate; // The buffer is (de)allocated by the next rendering
+}
+
+bool Render::distanceEstimation() const noexcept
+{
+    return m_estimateDistance;
+}
+
+const FrameVector<float>& Render::getDistanceEstimate() const noexcept
+{
+    return m_distance;
+}
+
+void Render::setFormula(const Formula &formula) noexcept
+{
+    if(formula == m_formula)
+        return;
+
+    // The rendering in progress is of the old formula, and uses the cache
+    abort();
+    m_formula = formula;
+    m_cache.clear();
+    m_renderedView.detailLevel = 0;
+    m_histogramDetailValid = false;
+}
+
+const Formula& Render::getFormula() const noexcept
+{
+    return m_formula;
+}
+
+sf::Vector2<double> Render::getCenter() const noexcept
+{
+    const ViewGeometry<double> geometry(m_imageSize, m_scale, getNormalizedPosition());
+    return sf::Vector2<double>(geometry.real(m_imageSize.x / 2), geometry.imag(m_imageSize.y / 2));
+}
+
+bool Render::findNucleus(Nucleus &nucleus)
+{
+    if(m_formula != Formula())
+        return false;
+
+    // The precision of GMP is global : the renderings of this view are stopped, a deep screenshot may still use it
+    abort();
+    std::unique_lock<std::mutex> gmpLock(gmpPrecisionMutex(), std::defer_lock);
+    if(getPrecision(m_scale) == Snapshot::Precision::Gmp && !gmpLock.try_lock())
+        return false;
+    return locateNucleus(m_imageSize, m_scale, getNormalizedPosition(), m_detailLevel, nucleus);
+}
+
+void Render::setPaletteMode(Palette::Mode mode) noexcept
+{
+    m_palette.setMode(mode);
+}
+
+Palette::Mode Render::getPaletteMode() const noexcept
+{
+    return m_palette.getMode();
+}
+
+void Render::recolor() noexcept
+{
+    // A running rendering colours its frame at the end anyway
+    if(isRenderingFinished() && m_renderedView.detailLevel != 0){
+        m_palette.colorize(m_iterations, m_distance, m_data, m_renderedView.detailLevel);
+    }
+}
+
+bool Render::copySnapshot(Snapshot::Frame &frame) const
+{
+    if(!isRenderingFinished() || m_renderedView.detailLevel == 0)
+        return false;
+
+    const Snapshot::View view { getPrecision(m_renderedView.scale), m_imageSize, m_renderedView.detailLevel,
+                                m_renderedView.scale, m_renderedView.normalizedPosition, m_formula };
+    const std::size_t pixelCount = m_iterations.size();
+
+    const void* orbits = nullptr;
+    std::size_t orbitSize = 0;
+    switch(view.precision)
+    {
+        case Snapshot::Precision::Float :
+            orbits = getOrbitData(m_floatOrbits, pixelCount);
+            orbitSize = sizeof(OrbitState<float>);
+            break;
+        case Snapshot::Precision::Double :
+            orbits = getOrbitData(m_doubleOrbits, pixelCount);
+            orbitSize = sizeof(OrbitState<double>);
+            break;
+        case Snapshot::Precision::Float128 :
+            orbits = getOrbitData(m_float128Orbits, pixelCount);
+            orbitSize = sizeof(OrbitState<__float128>);
+            break;
+        default : // The limbs of a mpf_class aren't in the object, these orbits aren't saved
+            break;
+    }
+
+    frame.view = view;
+    frame.iterations.assign(m_iterations.begin(), m_iterations.end());
+    frame.distance.assign(m_distance.begin(), m_distance.end());
+    if(orbits){
+        frame.orbits.assign(static_cast<const char*>(orbits), static_cast<const char*>(orbits) + pixelCount * orbitSize);
+    }else{
+        frame.orbits.clear();
+    }
+    frame.orbitSize = orbitSize;
+    return true;
+}
+
+bool Render::loadSnapshot(const std::string &fileName)
+{
+    terminateAllThread();
+
+    Snapshot snapshot;
+    if(!snapshot.open(fileName) || snapshot.getView().size != m_imageSize)
+        return false;
+
+    const Snapshot::View& view = snapshot.getView();
+    const std::size_t pixelCount = m_iterations.size();
+
+    setFormula(view.formula);
+    setZoom(view.zoom);
+    setNormalizedPosition(view.normalizedPosition);
+    m_detailLevel = view.detailLevel;
+    m_histogramDetailValid = true;
+
+    std::copy(snapshot.getIterations(), snapshot.getIterations() + pixelCount, m_iterations.begin());
+
+    m_estimateDistance = (snapshot.getDistance() != nullptr);
+    if(m_estimateDistance){
+        m_distance.assign(snapshot.getDistance(), snapshot.getDistance() + pixelCount);
+    }else{
+        FrameVector<float>().swap(m_distance);
+    }
+
+    // Raising the detail level resumes the saved orbits, if they are of the precision of this zoom
+    FrameVector<OrbitState<float>>().swap(m_floatOrbits);
+    FrameVector<OrbitState<double>>().swap(m_doubleOrbits);
+    FrameVector<OrbitState<__float128>>().swap(m_float128Orbits);
+    FrameVector<OrbitState<mpf_class>>().swap(m_gmpOrbits);
+    if(view.precision == getPrecision(m_scale))
+    {
+        switch(view.precision)
+        {
+            case Snapshot::Precision::Float    : loadOrbits(snapshot, m_floatOrbits, pixelCount); break;
+            case Snapshot::Precision::Double   : loadOrbits(snapshot, m_doubleOrbits, pixelCount); break;
+            case Snapshot::Precision::Float128 : loadOrbits(snapshot, m_float128Orbits, pixelCount); break;
+            default : break;
+        }
+    }
+
+    m_renderedView.scale = m_scale;
+    m_renderedView.normalizedPosition = m_normalizedPosition;
+    m_renderedView.detailLevel = m_detailLevel;
+
+    m_palette.colorize(m_iterations, m_distance, m_data, m_detailLevel);
+    return true;
 }
 
 void Render::setNormalizedPosition(sf::Vector2<double> position) noexcept
 {
     m_normalizedPosition = position;
+    m_histogramDetailValid = false;
     if(m_scale > getGmpRenderBeginning()){
             mpf_set_d(m_gmp_normalizedPosition.x.get_mpf_t(), m_normalizedPosition.x);
             mpf_set_d(m_gmp_normalizedPosition.y.get_mpf_t(), m_normalizedPosition.y);
@@ -95,15 +326,134 @@ sf::Vector2<double> Render::getNormalizedPosition() const noexcept
 
 const sf::Texture& Render::getTexture()noexcept
 {
+    TRACE_SPAN("texture upload");
     m_texture.update(m_data.data());
     return m_texture;
 }
 
+bool Render::renderPreview(const sf::Vector2u size, const sf::Time deadline, sf::Time &time)
+{
+    // The view changed since the rendering started, it is dropped
+    abort();
+
+    // Not waited for, it would block the input
+    time = sf::Time::Zero;
+    std::unique_lock<std::mutex> gmpLock(gmpPrecisionMutex(), std::defer_lock);
+    if(getPrecision(m_scale) == Snapshot::Precision::Gmp && !gmpLock.try_lock())
+        return false;
+
+    TRACE_SPAN("preview");
+    sf::Clock clock;
+    const sf::Vector2u previewSize(std::min(size.x, m_imageSize.x), std::min(size.y, m_imageSize.y));
+    m_previewIterations.resize(static_cast<std::size_t>(previewSize.x) * previewSize.y);
+    m_previewData.resize(m_previewIterations.size() * 4);
+
+    // The kernel checks m_previewRun between its tiles, the timer clears it at the deadline
+    // unless the preview is finished first
+    m_mutexForBoolean.lock();
+    m_previewRun = true;
+    m_mutexForBoolean.unlock();
+    std::mutex timerMutex;
+    std::condition_variable previewFinished;
+    bool finished = false;
+    sf::Thread timer([&]{
+        std::unique_lock<std::mutex> lock(timerMutex);
+        if(!previewFinished.wait_for(lock, std::chrono::microseconds(deadline.asMicroseconds()), [&]{ return finished; })){
+            m_mutexForBoolean.lock();
+            m_previewRun = false;
+            m_mutexForBoolean.unlock();
+        }
+    });
+    timer.launch();
+
+    bool complete = false;
+    switch(getPrecision(m_scale))
+    {
+        case Snapshot::Precision::Float    : complete = previewWith<float>(previewSize); break;
+        case Snapshot::Precision::Double   : complete = previewWith<double>(previewSize); break;
+        case Snapshot::Precision::Float128 : complete = previewWith<__float128>(previewSize); break;
+        default                            : complete = previewWith<mpf_class>(previewSize); break;
+    }
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        finished = true;
+    }
+    previewFinished.notify_one();
+    timer.wait();
+
+    time = clock.getElapsedTime();
+    if(!complete)
+        return false;
+
+    m_palette.colorize(m_previewIterations, FrameVector<float>(), m_previewData, m_detailLevel);
+    {
+        TRACE_SPAN("texture upload");
+        m_previewTexture.update(m_previewData.data(), previewSize.x, previewSize.y, 0, 0);
+    }
+    return true;
+}
+
+const sf::Texture& Render::getPreviewTexture() const noexcept
+{
+    return m_previewTexture;
+}
+
+bool Render::copyPixels(std::vector<sf::Uint8> &pixels) const
+{
+    if(!isRenderingFinished())
+        return false;
+    pixels.assign(m_data.begin(), m_data.end());
+    return true;
+}
+
+sf::Vector2u Render::getImageSize() const noexcept
+{
+    return m_imageSize;
+}
+
 bool Render::isRenderingFinished() const noexcept
 {
     return m_isRenderingFinished;
 }
 
+bool Render::waitRendering(sf::Time timeout)
+{
+    std::unique_lock<std::mutex> lock(m_finishedMutex);
+    return m_renderingFinished.wait_for(lock, std::chrono::microseconds(timeout.asMicroseconds()),
+                                        [this]{ return isRenderingFinished(); });
+}
+
+void Render::prefetch(const std::vector<View> &views)
+{
+    // The detail level of the histogram mode isn't known before a probe of the view
+    if(m_detailMode == DetailMode::Histogram || m_estimateDistance || !isRenderingFinished())
+        return;
+
+    // The finished rendering may still store its frame in the cache
+    terminateAllThread();
+
+    m_prefetchQueue.clear();
+    for(const View& view : views)
+    {
+        const unsigned detailLevel = (m_detailMode == DetailMode::Zoom ? getDetailForZoom(view.scale) : m_detailLevel);
+        if(findInCache(view.scale, view.normalizedPosition, detailLevel) == m_cache.end())
+            m_prefetchQueue.push_back(CachedView{view.scale, view.normalizedPosition, detailLevel, {}});
+    }
+
+    if(!m_prefetchQueue.empty() && m_cacheBudget > 0){
+        m_prefetchRun = true;
+        m_prefetchThread.launch();
+    }
+}
+
+void Render::setPrefetchBudget(unsigned threadCount, std::size_t cacheBytes) noexcept
+{
+    terminateAllThread();
+    m_prefetchThreadCount = std::max(1u, threadCount);
+    m_cacheBudget = cacheBytes;
+    shrinkCache();
+}
+
 void Render::performRendering() noexcept
 {
     terminateAllThread();
@@ -112,38 +462,160 @@ void Render::performRendering() noexcept
 
 void Render::performRenderingSync() noexcept
 {
+    stopPrefetch();
+    // After an abort, the rendering is run again on this thread
+    m_mutexForBoolean.lock();
+    m_threadRun = true;
+    m_mutexForBoolean.unlock();
     launchRendering();
 }
 
 void Render::abort() noexcept
 {
+    // The kernel checks m_threadRun between its tiles
+    m_mutexForBoolean.lock();
+    m_threadRun = false;
+    m_mutexForBoolean.unlock();
     terminateAllThread();
 }
 
 long double Render::getGmpRenderBeginning() const noexcept
 {
-    return 1e25;
+    return gmpRenderBeginning;
 }
 
 double Render::getLongDoubleRenderBeginning() const noexcept
 {
-    return 1e13;
+    return float128RenderBeginning;
 }
 
 float Render::getDoubleRenderBeginning() const noexcept
 {
-    return 2e4;
+    return doubleRenderBeginning;
 }
 
 // PRIVATE
 void Render::launchRendering() noexcept
 {
-    if(m_scale < getDoubleRenderBeginning())
-        mandelbrotRendererPrimitive<float>(m_data, m_imageSize, m_scale, m_detailLevel, m_normalizedPosition, m_threadRun, m_isRenderingFinished, m_mutexForBoolean);
-    else if(m_scale < getLongDoubleRenderBeginning())
-        mandelbrotRendererPrimitive<double>(m_data, m_imageSize, m_scale, m_detailLevel, m_normalizedPosition, m_threadRun, m_isRenderingFinished, m_mutexForBoolean);
+    TRACE_SPAN("render");
+
+    m_mutexForBoolean.lock();
+    m_isRenderingFinished = false;
+    m_mutexForBoolean.unlock();
+
+    if(m_estimateDistance){
+        m_distance.resize(m_imageSize.x * m_imageSize.y, 0.f);
+    }else{
+        FrameVector<float>().swap(m_distance);
+    }
+
+    // A deep screenshot may be computing in GMP : the rendering waits for it, unless it is stopped first.
+    // Then the frame is only coloured again, and not resumable
+    std::unique_lock<std::mutex> gmpLock(gmpPrecisionMutex(), std::defer_lock);
+    if(getPrecision(m_scale) == Snapshot::Precision::Gmp && !lockGmpPrecision(gmpLock, m_threadRun, m_mutexForBoolean)){
+        m_renderedView.detailLevel = 0;
+    }else if(m_detailMode == DetailMode::Histogram && !m_histogramDetailValid){
+        // Stopped, the kernel below stops too
+        const unsigned detailLevel = getDetailFromHistogram();
+        if(detailLevel != 0){
+            m_detailLevel = detailLevel;
+            m_histogramDetailValid = true;
+        }
+    }
+
+    // A view computed ahead, or already seen, is only coloured
+    const bool computable = (getPrecision(m_scale) != Snapshot::Precision::Gmp || gmpLock.owns_lock());
+    const bool cached = computable && loadFromCache();
+    if(computable && !cached)
+    {
+        // Only the orbits of the current precision are kept
+        if(m_scale < getDoubleRenderBeginning()){
+            FrameVector<OrbitState<double>>().swap(m_doubleOrbits);
+            FrameVector<OrbitState<__float128>>().swap(m_float128Orbits);
+            FrameVector<OrbitState<mpf_class>>().swap(m_gmpOrbits);
+            launchRenderingWith(m_floatOrbits);
+        }else if(m_scale < getLongDoubleRenderBeginning()){
+            FrameVector<OrbitState<float>>().swap(m_floatOrbits);
+            FrameVector<OrbitState<__float128>>().swap(m_float128Orbits);
+            FrameVector<OrbitState<mpf_class>>().swap(m_gmpOrbits);
+            launchRenderingWith(m_doubleOrbits);
+        }else if(m_scale < getGmpRenderBeginning()){
+            FrameVector<OrbitState<float>>().swap(m_floatOrbits);
+            FrameVector<OrbitState<double>>().swap(m_doubleOrbits);
+            FrameVector<OrbitState<mpf_class>>().swap(m_gmpOrbits);
+            launchRenderingWith(m_float128Orbits);
+        }else{
+            FrameVector<OrbitState<float>>().swap(m_floatOrbits);
+            FrameVector<OrbitState<double>>().swap(m_doubleOrbits);
+            FrameVector<OrbitState<__float128>>().swap(m_float128Orbits);
+            launchRenderingWith(m_gmpOrbits);
+        }
+    }
+    if(gmpLock.owns_lock())
+        gmpLock.unlock();
+
+    // The view may be changed as soon as the frame is finished
+    const bool store = (!cached && m_renderedView.detailLevel != 0 && !m_estimateDistance);
+    CachedView view{m_scale, m_normalizedPosition, m_detailLevel, {}};
+
+    m_palette.colorize(m_iterations, m_distance, m_data, m_detailLevel);
+
+    m_mutexForBoolean.lock();
+    m_isRenderingFinished = true;
+    m_mutexForBoolean.unlock();
+
+    // A waiting thread checks isRenderingFinished under m_finishedMutex, so it can't miss this
+    {
+        std::lock_guard<std::mutex> lock(m_finishedMutex);
+    }
+    m_renderingFinished.notify_all();
+
+    // Encoded once shown. The next rendering, and the prefetch which may use the cache, wait for this thread
+    if(store){
+        view.frame = EncodedFrame(m_iterations, m_imageSize);
+        storeInCache(std::move(view));
+    }
+}
+
+template <typename T>
+void Render::launchRenderingWith(FrameVector<OrbitState<T>> &orbits) noexcept
+{
+    // Raising the detail level of the same view only continues the pixels
+    // which reached the previous one. The distance estimate isn't resumable
+    const bool resume = !orbits.empty()
+                        && m_renderedView.detailLevel != 0
+                        && m_renderedView.detailLevel < m_detailLevel
+                        && m_renderedView.scale == m_scale
+                        && m_renderedView.normalizedPosition == m_normalizedPosition
+                        && !m_estimateDistance;
+
+    // A mpf_class keeps the precision it was built with, so the orbits are rebuilt for each view
+    NumberTraits<T>::setPrecision(precisionForZoom(m_scale, m_imageSize.y));
+    if(!resume){
+        orbits.clear();
+    }
+    orbits.resize(m_imageSize.x * m_imageSize.y);
+    const unsigned previousDetailLevel = (resume ? m_renderedView.detailLevel : 0);
+
+    ResumableOutput<T> output { m_iterations, orbits, m_distance };
+    const bool complete = mandelbrotKernel<T>(output, m_imageSize, m_scale, m_detailLevel, previousDetailLevel,
+                                              m_normalizedPosition, m_formula, m_threadRun, m_mutexForBoolean);
+
+    m_renderedView.scale = m_scale;
+    m_renderedView.normalizedPosition = m_normalizedPosition;
+    m_renderedView.detailLevel = (complete ? m_detailLevel : 0);
+}
+
+Snapshot::Precision Render::getPrecision(double zoom) const noexcept
+{
+    if(zoom < getDoubleRenderBeginning())
+        return Snapshot::Precision::Float;
+    else if(zoom < getLongDoubleRenderBeginning())
+        return Snapshot::Precision::Double;
+    else if(zoom < getGmpRenderBeginning())
+        return Snapshot::Precision::Float128;
     else
-        mandelbrotRendererPrimitive<__float128>(m_data, m_imageSize, m_scale, m_detailLevel, m_normalizedPosition, m_threadRun, m_isRenderingFinished, m_mutexForBoolean);
+        return Snapshot::Precision::Gmp;
 }
 
 void Render::launchAllThread()
@@ -155,11 +627,181 @@ void Render::launchAllThread()
 void Render::terminateAllThread()
 {
    // m_threadRun = false; Test; may stop crashing
+    stopPrefetch();
     m_renderThread.wait();
 }
 
+void Render::launchPrefetch() noexcept
+{
+    // Give way to everything else. On Linux the nice value is per thread, and the team
+    // of this thread is kept by OpenMP for its next parallel regions of the same size
+    #pragma omp parallel num_threads(m_prefetchThreadCount)
+    {
+        setpriority(PRIO_PROCESS, 0, 19);
+    }
+
+    for(CachedView& view : m_prefetchQueue)
+    {
+        TRACE_SPAN("prefetch");
+        m_prefetchIterations.resize(m_iterations.size());
+
+        std::unique_lock<std::mutex> gmpLock(gmpPrecisionMutex(), std::defer_lock);
+        if(getPrecision(view.scale) == Snapshot::Precision::Gmp && !lockGmpPrecision(gmpLock, m_prefetchRun, m_mutexForBoolean))
+            return;
+
+        bool complete = false;
+        switch(getPrecision(view.scale))
+        {
+            case Snapshot::Precision::Float    : complete = prefetchWith<float>(view); break;
+            case Snapshot::Precision::Double   : complete = prefetchWith<double>(view); break;
+            case Snapshot::Precision::Float128 : complete = prefetchWith<__float128>(view); break;
+            default                            : complete = prefetchWith<mpf_class>(view); break;
+        }
+
+        if(!complete)
+            return;
+        view.frame = EncodedFrame(m_prefetchIterations, m_imageSize, m_prefetchThreadCount);
+        storeInCache(std::move(view));
+    }
+}
+
+template <typename T>
+bool Render::prefetchWith(CachedView &view)
+{
+    IterationOutput<T> output { m_prefetchIterations };
+    return mandelbrotKernel<T>(output, m_imageSize, view.scale, view.detailLevel, 0, view.normalizedPosition, m_formula,
+                               m_prefetchRun, m_mutexForBoolean, m_prefetchThreadCount);
+}
+
+template <typename T>
+bool Render::previewWith(const sf::Vector2u size)
+{
+    IterationOutput<T> output { m_previewIterations };
+    return mandelbrotKernel<T>(output, size, m_scale, m_detailLevel, 0, m_normalizedPosition, m_formula,
+                               m_previewRun, m_mutexForBoolean);
+}
+
+void Render::stopPrefetch()
+{
+    m_mutexForBoolean.lock();
+    m_prefetchRun = false;
+    m_mutexForBoolean.unlock();
+    m_prefetchThread.wait();
+}
+
+std::list<Render::CachedView>::iterator Render::findInCache(double scale, sf::Vector2<double> normalizedPosition,
+                                                            unsigned detailLevel)
+{
+    return std::find_if(m_cache.begin(), m_cache.end(), [&](const CachedView& view){
+        return view.scale == scale && view.normalizedPosition == normalizedPosition && view.detailLevel == detailLevel;
+    });
+}
+
+bool Render::loadFromCache()
+{
+    if(m_estimateDistance)
+        return false;
+
+    const auto view = findInCache(m_scale, m_normalizedPosition, m_detailLevel);
+    if(view == m_cache.end())
+        return false;
+
+    view->frame.decode(m_iterations);
+    m_cache.splice(m_cache.begin(), m_cache, view);
+
+    // The orbits aren't cached, this frame can't be resumed
+    FrameVector<OrbitState<float>>().swap(m_floatOrbits);
+    FrameVector<OrbitState<double>>().swap(m_doubleOrbits);
+    FrameVector<OrbitState<__float128>>().swap(m_float128Orbits);
+    FrameVector<OrbitState<mpf_class>>().swap(m_gmpOrbits);
+
+    m_renderedView.scale = m_scale;
+    m_renderedView.normalizedPosition = m_normalizedPosition;
+    m_renderedView.detailLevel = m_detailLevel;
+    return true;
+}
+
+void Render::storeInCache(CachedView &&view)
+{
+    const auto previous = findInCache(view.scale, view.normalizedPosition, view.detailLevel);
+    if(previous != m_cache.end())
+        m_cache.erase(previous);
+
+    m_cache.push_front(std::move(view));
+    shrinkCache();
+}
+
+void Render::shrinkCache()
+{
+    // The encoded frames don't have the same size, the least recently used ones are dropped
+    std::size_t bytes = 0;
+    for(const CachedView& view : m_cache)
+        bytes += view.frame.getByteSize();
+
+    while(!m_cache.empty() && bytes > m_cacheBudget)
+    {
+        bytes -= m_cache.back().frame.getByteSize();
+        m_cache.pop_back();
+    }
+}
+
 unsigned Render::getDetailForZoom(double zoom) const
 {
-    unsigned details = sqrt(abs(2*sqrt(abs(1-sqrt(5*m_scale)))))*66.5;
+    unsigned details = sqrt(abs(2*sqrt(abs(1-sqrt(5*zoom)))))*66.5;
     return (details == 0 ? 30 : details);
 }
+
+unsigned Render::getDetailFromHistogram()
+{
+    // A pixel escaping after the limit is wrongly drawn black,
+    // we accept it for one probed pixel out of 'toleranceDivisor'
+    constexpr unsigned toleranceDivisor = 2000;
+    constexpr unsigned minimumDetail = 16;
+    constexpr unsigned maximumDetail = 1 << 16;
+
+    unsigned probeLimit = std::max(getDetailForZoom(m_scale) * 2, 64u);
+    while(true)
+    {
+        const std::vector<unsigned> histogram = probeEscapeHistogram(probeLimit);
+        if(histogram.empty())
+            return 0;
+        const unsigned probed = std::accumulate(histogram.begin(), histogram.end(), 0u);
+        const unsigned tolerance = probed / toleranceDivisor;
+
+        // Still many pixels escaping late : the boundary isn't resolved, look further
+        const unsigned lateEscapes = std::accumulate(histogram.begin() + probeLimit / 2, histogram.end() - 1, 0u);
+        if(lateEscapes > tolerance && probeLimit < maximumDetail){
+            probeLimit *= 2;
+            continue;
+        }
+
+        // Smallest limit leaving at most 'tolerance' escaping pixels black
+        unsigned detail = probeLimit;
+        unsigned wronglyBlack = 0;
+        while(detail > minimumDetail && wronglyBlack + histogram[detail - 1] <= tolerance){
+            wronglyBlack += histogram[detail - 1];
+            --detail;
+        }
+        return detail;
+    }
+}
+
+std::vector<unsigned> Render::probeEscapeHistogram(unsigned probeLimit)
+{
+    // One pixel out of probeStep in each direction
+    constexpr unsigned probeStep = 4;
+
+    #define PROBE(type) \
+        escapeIterationHistogram<type>(m_imageSize, m_scale, probeLimit, m_normalizedPosition, m_formula, probeStep, m_threadRun, m_mutexForBoolean)
+
+    // Past __float128, its probed pixels would fall on a few values of c
+    switch(getPrecision(m_scale))
+    {
+        case Snapshot::Precision::Float    : return PROBE(float);
+        case Snapshot::Precision::Double   : return PROBE(double);
+        case Snapshot::Precision::Float128 : return PROBE(__float128);
+        default                            : return PROBE(mpf_class);
+    }
+
+    #undef PROBE
+}
@@ -0,0 +1,76 @@
+#include "ResolutionController.h"
+
+// Std include
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Side of the full frame over the one of the first frame, before any measure
+    constexpr double firstScale = 8;
+
+    // Largest side of the full frame over the one of a frame, whatever it costs
+    constexpr double maximumScale = 32;
+
+    // Weight of the last frame in the cost of a pixel, the older ones fade out
+    constexpr double lastFrameWeight = 0.5;
+
+    // Deadline of a frame, in frame times. Missing it shrinks the next frame by as much
+    constexpr float deadlineScale = 4;
+}
+
+ResolutionController::ResolutionController(const sf::Vector2u fullSize, const sf::Time frameTime):
+    m_fullSize(fullSize),
+    m_frameTime(frameTime),
+    m_precision(Snapshot::Precision::Float),
+    m_detailLevel(1),
+    m_iterationCost(0)
+{}
+
+void ResolutionController::setFrameTime(const sf::Time frameTime) noexcept
+{
+    m_frameTime = frameTime;
+}
+
+sf::Time ResolutionController::getFrameTime() const noexcept
+{
+    return m_frameTime;
+}
+
+sf::Time ResolutionController::getDeadline() const noexcept
+{
+    return m_frameTime * deadlineScale;
+}
+
+void ResolutionController::setView(const Snapshot::Precision precision, const unsigned detailLevel) noexcept
+{
+    if(precision != m_precision)
+        m_iterationCost = 0;
+    m_precision = precision;
+    m_detailLevel = std::max(1u, detailLevel);
+}
+
+sf::Vector2u ResolutionController::getFrameSize() const noexcept
+{
+    double scale = firstScale;
+    if(m_iterationCost > 0){
+        // The pixels which fit in the frame time, the sides shrink as the square root of their count
+        const double fullPixels = static_cast<double>(m_fullSize.x) * m_fullSize.y;
+        const double pixels = m_frameTime.asSeconds() / (m_iterationCost * m_detailLevel);
+        scale = std::sqrt(fullPixels / std::max(pixels, 1.0));
+    }
+    scale = std::min(std::max(scale, 1.0), maximumScale);
+
+    return sf::Vector2u(std::max(1u, static_cast<unsigned>(std::lround(m_fullSize.x / scale))),
+                        std::max(1u, static_cast<unsigned>(std::lround(m_fullSize.y / scale))));
+}
+
+void ResolutionController::addFrame(const sf::Vector2u size, const sf::Time time) noexcept
+{
+    const double pixels = static_cast<double>(size.x) * size.y;
+    if(pixels == 0)
+        return;
+
+    const double cost = time.asSeconds() / (pixels * m_detailLevel);
+    m_iterationCost = (m_iterationCost > 0 ? lastFrameWeight * cost + (1 - lastFrameWeight) * m_iterationCost : cost);
+}
@@ -0,0 +1,110 @@
+#include "ScreenshotQueue.h"
+
+// Std include
+#include <iostream>
+
+// Sfml include
+// - Graphics
+#include <SFML/Graphics/Image.hpp>
+
+// Personal include
+#include "Trace.h"
+
+ScreenshotQueue::ScreenshotQueue():
+    m_jobs(),
+    m_stop(false),
+    m_mutex(),
+    m_jobQueued(),
+    m_thread(&ScreenshotQueue::run, this)
+{
+    m_thread.launch();
+}
+
+ScreenshotQueue::~ScreenshotQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobQueued.notify_one();
+    m_thread.wait();
+}
+
+void ScreenshotQueue::push(const std::string &fileName, const sf::Vector2u size, std::vector<sf::Uint8> &&pixels)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(Job{fileName, size, std::move(pixels), nullptr, nullptr});
+    }
+    m_jobQueued.notify_one();
+}
+
+void ScreenshotQueue::push(const std::string &fileName, std::unique_ptr<Poster> poster)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(Job{fileName, sf::Vector2u(), std::vector<sf::Uint8>(), std::move(poster), nullptr});
+    }
+    m_jobQueued.notify_one();
+}
+
+void ScreenshotQueue::push(const std::string &fileName, std::unique_ptr<Snapshot::Frame> snapshot)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(Job{fileName, sf::Vector2u(), std::vector<sf::Uint8>(), nullptr, std::move(snapshot)});
+    }
+    m_jobQueued.notify_one();
+}
+
+std::size_t ScreenshotQueue::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+// PRIVATE
+void ScreenshotQueue::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        m_jobQueued.wait(lock, [this]{ return m_stop || !m_jobs.empty(); });
+        if(m_jobs.empty())
+            return; // Stopped, and everything is written
+
+        // The front job stays in the queue while it is written, so it is counted as pending.
+        // A deque doesn't move its elements when others are pushed
+        Job &job = m_jobs.front();
+        lock.unlock();
+        write(job);
+        lock.lock();
+        m_jobs.pop_front();
+    }
+}
+
+void ScreenshotQueue::write(Job &job)
+{
+    if(job.snapshot){
+        TRACE_SPAN("snapshot writing");
+        if(!Snapshot::save(job.fileName, *job.snapshot)){
+            std::cerr << "Can not write \"" << job.fileName << "\"\n";
+        }
+        return;
+    }
+
+    if(job.poster){
+        job.size = job.poster->getSize();
+        if(!job.poster->renderPixels(job.pixels)){
+            std::cerr << "Can not render \"" << job.fileName << "\"\n";
+            return;
+        }
+    }
+
+    TRACE_SPAN("png encoding");
+    sf::Image image;
+    image.create(job.size.x, job.size.y, job.pixels.data());
+    if(!image.saveToFile(job.fileName)){
+        std::cerr << "Can not write \"" << job.fileName << "\"\n";
+    }
+}
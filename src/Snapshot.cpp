@@ -0,0 +1,236 @@
+#include "Snapshot.h"
+
+// Std include
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+// Posix include
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "omp.h"
+
+namespace
+{
+    const char snapshotMagic[8] = {'M', 'A', 'N', 'D', 'S', 'N', 'A', 'P'};
+    // The version 1 has no formula, its header is followed by zeros : the Mandelbrot set
+    constexpr sf::Uint32 snapshotVersion = 2;
+
+    // The buffers start on cache lines, so they can be used in place from the mapping
+    constexpr std::uint64_t sectionAlignment = 64;
+
+    // Bytes written by each pwrite, a buffer is written by several threads
+    constexpr std::uint64_t writeChunk = 1 << 22;
+
+    // First bytes of the file, in the byte order of the machine
+    struct FileHeader
+    {
+        char magic[8];
+        sf::Uint32 version;
+        sf::Uint32 precision;
+        sf::Uint32 width;
+        sf::Uint32 height;
+        sf::Uint32 detailLevel;
+        sf::Uint32 orbitSize;        // 0 if the orbits aren't saved
+        double zoom;
+        double positionX;
+        double positionY;
+        std::uint64_t iterationsOffset;
+        std::uint64_t distanceOffset; // 0 if the distance isn't saved
+        std::uint64_t orbitsOffset;   // 0 if the orbits aren't saved
+        sf::Uint32 formulaKind;       // Formula::Kind
+        sf::Uint32 formulaPower;
+        double juliaReal;
+        double juliaImag;
+    };
+
+    std::uint64_t align(const std::uint64_t offset)
+    {
+        return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+    }
+
+    bool writeSection(const int file, const void* data, const std::uint64_t bytes, const std::uint64_t offset)
+    {
+        const long long chunkCount = (bytes + writeChunk - 1) / writeChunk;
+        bool ok = true;
+
+        #pragma omp parallel for num_threads(8) schedule(dynamic) reduction(&&:ok)
+        for(long long chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            std::uint64_t done = chunk * writeChunk;
+            const std::uint64_t end = std::min(bytes, done + writeChunk);
+            while(ok && done < end)
+            {
+                const ssize_t written = pwrite(file, static_cast<const char*>(data) + done, end - done, offset + done);
+                if(written <= 0)
+                    ok = false;
+                else
+                    done += written;
+            }
+        }
+        return ok;
+    }
+}
+
+Snapshot::Snapshot():
+    m_mapping(nullptr),
+    m_mappingSize(0),
+    m_view(),
+    m_iterations(nullptr),
+    m_distance(nullptr),
+    m_orbits(nullptr),
+    m_orbitSize(0)
+{}
+
+Snapshot::~Snapshot()
+{
+    close();
+}
+
+bool Snapshot::save(const std::string &fileName, const Frame &frame)
+{
+    const View &view = frame.view;
+    const std::uint64_t pixelCount = static_cast<std::uint64_t>(view.size.x) * view.size.y;
+    if(frame.iterations.size() != pixelCount || (!frame.distance.empty() && frame.distance.size() != pixelCount)
+       || (!frame.orbits.empty() && frame.orbits.size() != pixelCount * frame.orbitSize))
+        return false;
+
+    FileHeader header;
+    std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+    header.version = snapshotVersion;
+    header.precision = static_cast<sf::Uint32>(view.precision);
+    header.width = view.size.x;
+    header.height = view.size.y;
+    header.detailLevel = view.detailLevel;
+    header.orbitSize = (frame.orbits.empty() ? 0 : frame.orbitSize);
+    header.zoom = view.zoom;
+    header.positionX = view.normalizedPosition.x;
+    header.positionY = view.normalizedPosition.y;
+    header.formulaKind = static_cast<sf::Uint32>(view.formula.kind);
+    header.formulaPower = view.formula.power;
+    header.juliaReal = view.formula.juliaReal;
+    header.juliaImag = view.formula.juliaImag;
+
+    const std::uint64_t iterationsBytes = pixelCount * sizeof(unsigned);
+    const std::uint64_t distanceBytes = (frame.distance.empty() ? 0 : pixelCount * sizeof(float));
+    const std::uint64_t orbitsBytes = pixelCount * header.orbitSize;
+
+    header.iterationsOffset = align(sizeof(FileHeader));
+    header.distanceOffset = (distanceBytes ? align(header.iterationsOffset + iterationsBytes) : 0);
+    const std::uint64_t distanceEnd = (distanceBytes ? header.distanceOffset + distanceBytes : header.iterationsOffset + iterationsBytes);
+    header.orbitsOffset = (orbitsBytes ? align(distanceEnd) : 0);
+    const std::uint64_t fileSize = (orbitsBytes ? header.orbitsOffset + orbitsBytes : distanceEnd);
+
+    const int file = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(file < 0)
+        return false;
+
+    // The file has its final size before the threads write in it
+    bool ok = ftruncate(file, fileSize) == 0
+              && writeSection(file, &header, sizeof(header), 0)
+              && writeSection(file, frame.iterations.data(), iterationsBytes, header.iterationsOffset)
+              && writeSection(file, frame.distance.data(), distanceBytes, header.distanceOffset)
+              && writeSection(file, frame.orbits.data(), orbitsBytes, header.orbitsOffset);
+
+    ok = (::close(file) == 0) && ok;
+    return ok;
+}
+
+bool Snapshot::open(const std::string &fileName)
+{
+    close();
+
+    const int file = ::open(fileName.c_str(), O_RDONLY);
+    if(file < 0)
+        return false;
+
+    struct stat status;
+    if(fstat(file, &status) != 0 || static_cast<std::uint64_t>(status.st_size) < sizeof(FileHeader)){
+        ::close(file);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); // The mapping keeps the file
+    if(mapping == MAP_FAILED)
+        return false;
+
+    m_mapping = mapping;
+    m_mappingSize = status.st_size;
+
+    const FileHeader& header = *static_cast<const FileHeader*>(m_mapping);
+    const std::uint64_t pixelCount = static_cast<std::uint64_t>(header.width) * header.height;
+    const auto fits = [this](std::uint64_t offset, std::uint64_t bytes){
+        return offset % sectionAlignment == 0 && offset <= m_mappingSize && bytes <= m_mappingSize - offset;
+    };
+
+    if(std::memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0
+       || header.version == 0 || header.version > snapshotVersion
+       || header.precision > static_cast<sf::Uint32>(Precision::Gmp)
+       || header.formulaKind > static_cast<sf::Uint32>(Formula::Kind::Julia)
+       || !fits(header.iterationsOffset, pixelCount * sizeof(unsigned))
+       || (header.distanceOffset && !fits(header.distanceOffset, pixelCount * sizeof(float)))
+       || (header.orbitsOffset && !fits(header.orbitsOffset, pixelCount * header.orbitSize)))
+    {
+        close();
+        return false;
+    }
+
+    const char* bytes = static_cast<const char*>(m_mapping);
+    m_view.precision = static_cast<Precision>(header.precision);
+    m_view.size = sf::Vector2u(header.width, header.height);
+    m_view.detailLevel = header.detailLevel;
+    m_view.zoom = header.zoom;
+    m_view.normalizedPosition = sf::Vector2<double>(header.positionX, header.positionY);
+    m_view.formula = Formula(static_cast<Formula::Kind>(header.formulaKind), header.formulaPower,
+                             header.juliaReal, header.juliaImag);
+    m_iterations = reinterpret_cast<const unsigned*>(bytes + header.iterationsOffset);
+    m_distance = (header.distanceOffset ? reinterpret_cast<const float*>(bytes + header.distanceOffset) : nullptr);
+    m_orbits = (header.orbitsOffset ? bytes + header.orbitsOffset : nullptr);
+    m_orbitSize = (header.orbitsOffset ? header.orbitSize : 0);
+
+    // The buffers are read once, from the beginning to the end
+    madvise(m_mapping, m_mappingSize, MADV_SEQUENTIAL);
+    return true;
+}
+
+void Snapshot::close() noexcept
+{
+    if(m_mapping){
+        munmap(m_mapping, m_mappingSize);
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_iterations = nullptr;
+    m_distance = nullptr;
+    m_orbits = nullptr;
+    m_orbitSize = 0;
+}
+
+const Snapshot::View& Snapshot::getView() const noexcept
+{
+    return m_view;
+}
+
+const unsigned* Snapshot::getIterations() const noexcept
+{
+    return m_iterations;
+}
+
+const float* Snapshot::getDistance() const noexcept
+{
+    return m_distance;
+}
+
+const void* Snapshot::getOrbits() const noexcept
+{
+    return m_orbits;
+}
+
+std::size_t Snapshot::getOrbitSize() const noexcept
+{
+    return m_orbitSize;
+}
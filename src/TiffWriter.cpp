@@ -0,0 +1,179 @@
+#include "TiffWriter.h"
+
+// Std include
+#include <algorithm>
+
+// Personal include
+#include "JobManifest.h"
+#include "Trace.h"
+
+namespace
+{
+    enum FieldType : std::uint16_t
+    {
+        Short = 3,
+        Long  = 4,
+        Long8 = 16
+    };
+
+    struct Field
+    {
+        std::uint16_t tag;
+        FieldType type;
+        std::vector<std::uint64_t> values;
+    };
+
+    unsigned getTypeSize(const FieldType type)
+    {
+        return (type == Short ? 2 : (type == Long ? 4 : 8));
+    }
+
+    // The file is written little-endian ( "II" )
+    void put(std::vector<sf::Uint8> &buffer, const std::uint64_t value, const unsigned bytes)
+    {
+        for(unsigned b = 0; b < bytes; ++b)
+            buffer.push_back(static_cast<sf::Uint8>(value >> (8 * b)));
+    }
+
+    // Header, then the only IFD, then the values too big to be in their IFD entry
+    std::vector<sf::Uint8> buildHeader(const std::vector<Field> &fields, const bool big)
+    {
+        const unsigned offsetBytes = (big ? 8 : 4);
+        const std::uint64_t headerBytes = (big ? 16 : 8);
+        const std::uint64_t ifdBytes = (big ? 8 : 2) + fields.size() * (big ? 20 : 12) + offsetBytes;
+
+        std::vector<sf::Uint8> header;
+        std::vector<sf::Uint8> values;
+
+        put(header, 'I' | ('I' << 8), 2);
+        put(header, (big ? 43 : 42), 2);
+        if(big){
+            put(header, offsetBytes, 2);
+            put(header, 0, 2);
+        }
+        put(header, headerBytes, offsetBytes);
+
+        put(header, fields.size(), (big ? 8 : 2));
+        for(const Field& field : fields)
+        {
+            const unsigned typeSize = getTypeSize(field.type);
+            const std::uint64_t bytes = field.values.size() * typeSize;
+
+            put(header, field.tag, 2);
+            put(header, field.type, 2);
+            put(header, field.values.size(), offsetBytes);
+            if(bytes <= offsetBytes){
+                for(std::uint64_t value : field.values)
+                    put(header, value, typeSize);
+                put(header, 0, offsetBytes - bytes);
+            }else{
+                put(header, headerBytes + ifdBytes + values.size(), offsetBytes);
+                for(std::uint64_t value : field.values)
+                    put(values, value, typeSize);
+            }
+        }
+        put(header, 0, offsetBytes); // No next IFD
+
+        header.insert(header.end(), values.begin(), values.end());
+        return header;
+    }
+}
+
+TiffWriter::TiffWriter():
+    m_file(),
+    m_fileName(),
+    m_size(0, 0),
+    m_rowsPerStrip(1),
+    m_dataOffset(0)
+{}
+
+bool TiffWriter::open(const std::string &fileName, const sf::Vector2u size, const unsigned rowsPerStrip,
+                      const bool keepStrips)
+{
+    m_size = size;
+    m_rowsPerStrip = std::max(1u, std::min(rowsPerStrip, size.y));
+
+    const unsigned stripCount = getStripCount();
+    const std::uint64_t imageBytes = static_cast<std::uint64_t>(size.x) * size.y * 3;
+    // The classic header is at most this big
+    const std::uint64_t classicHeaderBytes = 8 + 2 + 10 * 12 + 4 + 6 + 2 * 4 * static_cast<std::uint64_t>(stripCount);
+    const bool big = classicHeaderBytes + imageBytes > 0xFFFFFFFFu;
+
+    std::vector<std::uint64_t> stripOffsets(stripCount);
+    std::vector<std::uint64_t> stripSizes(stripCount);
+    for(unsigned strip = 0; strip < stripCount; ++strip)
+        stripSizes[strip] = getStripSize(strip);
+
+    std::vector<Field> fields = {
+        {256, Long,  {size.x}},                 // ImageWidth
+        {257, Long,  {size.y}},                 // ImageLength
+        {258, Short, {8, 8, 8}},                // BitsPerSample
+        {259, Short, {1}},                      // Compression : none
+        {262, Short, {2}},                      // PhotometricInterpretation : RGB
+        {273, (big ? Long8 : Long), {}},        // StripOffsets
+        {277, Short, {3}},                      // SamplesPerPixel
+        {278, Long,  {m_rowsPerStrip}},         // RowsPerStrip
+        {279, (big ? Long8 : Long), stripSizes},// StripByteCounts
+        {284, Short, {1}}                       // PlanarConfiguration : RGBRGB...
+    };
+
+    // The size of the header doesn't depend on the strip offsets, which depend on it
+    fields[5].values = stripOffsets;
+    m_dataOffset = (buildHeader(fields, big).size() + 15) / 16 * 16;
+    for(unsigned strip = 0; strip < stripCount; ++strip)
+        stripOffsets[strip] = getStripOffset(strip);
+    fields[5].values = stripOffsets;
+
+    const std::vector<sf::Uint8> header = buildHeader(fields, big);
+
+    m_fileName = fileName;
+    m_file.open(fileName, std::ios::binary | (keepStrips ? std::ios::in : std::ios::trunc));
+    m_file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    return m_file.good();
+}
+
+bool TiffWriter::writeStrip(const unsigned strip, const std::vector<sf::Uint8> &rgb)
+{
+    TRACE_SPAN_ARG("tiff write", strip);
+
+    const std::uint64_t stripSize = getStripSize(strip);
+    if(strip >= getStripCount() || rgb.size() < stripSize)
+        return false;
+
+    m_file.seekp(getStripOffset(strip));
+    m_file.write(reinterpret_cast<const char*>(rgb.data()), stripSize);
+    return m_file.good();
+}
+
+bool TiffWriter::flush()
+{
+    m_file.flush();
+    return m_file.good() && JobManifest::syncFile(m_fileName);
+}
+
+bool TiffWriter::close()
+{
+    m_file.close();
+    return !m_file.fail();
+}
+
+unsigned TiffWriter::getStripCount() const noexcept
+{
+    return (m_size.y + m_rowsPerStrip - 1) / m_rowsPerStrip;
+}
+
+unsigned TiffWriter::getStripRows(const unsigned strip) const noexcept
+{
+    return std::min(m_rowsPerStrip, m_size.y - strip * m_rowsPerStrip);
+}
+
+// PRIVATE
+std::uint64_t TiffWriter::getStripOffset(const unsigned strip) const noexcept
+{
+    return m_dataOffset + static_cast<std::uint64_t>(strip) * m_rowsPerStrip * m_size.x * 3;
+}
+
+std::uint64_t TiffWriter::getStripSize(const unsigned strip) const noexcept
+{
+    return static_cast<std::uint64_t>(getStripRows(strip)) * m_size.x * 3;
+}
@@ -0,0 +1,133 @@
+#include "Trace.h"
+
+// Std include
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        std::int64_t arg;
+        std::uint64_t begin;
+        std::uint64_t duration;
+    };
+
+    // Written by its thread only, read by Trace::dump
+    struct ThreadBuffer
+    {
+        unsigned id;
+        std::atomic<std::uint64_t> written; // Events recorded since the start, the ring keeps the last ones
+        Event events[Trace::ringCapacity];
+    };
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // The buffers outlive their thread, so the spans of a finished thread are still dumped.
+    // Each render launches a new thread and OpenMP team : a new thread continues the ring
+    // of a finished one, and its id, instead of adding a buffer
+    std::mutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::vector<ThreadBuffer*> freeBuffers; // Of the finished threads
+
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+
+    // Gives the buffer of its thread back when the thread ends
+    struct BufferRelease
+    {
+        ~BufferRelease()
+        {
+            if(!threadBuffer)
+                return;
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            freeBuffers.push_back(threadBuffer);
+            threadBuffer = nullptr;
+        }
+    };
+    thread_local BufferRelease bufferRelease;
+
+    ThreadBuffer* registerThread()
+    {
+        static_cast<void>(&bufferRelease); // Built by this use, so destroyed at the end of the thread
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        if(!freeBuffers.empty()){
+            ThreadBuffer* buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+            return buffer;
+        }
+
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+        buffer->written = 0;
+        buffer->id = buffers.size() + 1;
+        buffers.push_back(std::move(buffer));
+        return buffers.back().get();
+    }
+}
+
+std::uint64_t Trace::now() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Trace::record(const char* name, const std::uint64_t begin, const std::int64_t arg) noexcept
+{
+    const std::uint64_t end = now();
+    if(!threadBuffer)
+        threadBuffer = registerThread();
+
+    const std::uint64_t index = threadBuffer->written.load(std::memory_order_relaxed);
+    threadBuffer->events[index & (ringCapacity - 1)] = Event{name, arg, begin, end - begin};
+    threadBuffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::dump(const std::string &fileName)
+{
+    if(!enabled)
+        return false;
+
+    std::ofstream file(fileName);
+    file << "{\"traceEvents\":[\n";
+    file.precision(3);
+    file << std::fixed;
+
+    bool first = true;
+    std::vector<Event> events;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for(const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+    {
+        // The thread may record while its buffer is copied :
+        // the events it could have overwritten meanwhile are dropped
+        const std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const std::uint64_t oldest = (written > ringCapacity ? written - ringCapacity : 0);
+        events.clear();
+        for(std::uint64_t e = oldest; e < written; ++e)
+            events.push_back(buffer->events[e & (ringCapacity - 1)]);
+
+        const std::uint64_t rewritten = buffer->written.load(std::memory_order_acquire);
+        const std::uint64_t valid = (rewritten > ringCapacity ? rewritten - ringCapacity : 0);
+        const std::size_t skipped = (valid > oldest ? std::min<std::uint64_t>(valid - oldest, events.size()) : 0);
+
+        for(std::size_t e = skipped; e < events.size(); ++e)
+        {
+            const Event& event = events[e];
+            file << (first ? "" : ",\n")
+                 << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                 << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << event.duration / 1000.0;
+            if(event.arg >= 0)
+                file << ",\"args\":{\"n\":" << event.arg << '}';
+            file << '}';
+            first = false;
+        }
+    }
+
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return file.good();
+}